@@ -9,4 +9,6 @@ else
     yes | cp -rf "$FFMPEG_PATCH_DIR"/avcodec.h "$FFMPEG_INSTALL_DIR"/libavcodec/
     yes | cp -rf "$FFMPEG_PATCH_DIR"/rtpdec.c "$FFMPEG_INSTALL_DIR"/libavformat/
     yes | cp -rf "$FFMPEG_PATCH_DIR"/utils.c "$FFMPEG_INSTALL_DIR"/libavformat/
+    patch -p1 -N -d "$FFMPEG_INSTALL_DIR" < "$FFMPEG_PATCH_DIR"/h264dec.patch
+    patch -p1 -N -d "$FFMPEG_INSTALL_DIR" < "$FFMPEG_PATCH_DIR"/mb_types.patch
 fi
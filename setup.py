@@ -4,7 +4,7 @@ from pathlib import Path
 import numpy as np
 
 
-pkgconfig_result = pkgconfig.parse('libavformat libswscale opencv4')
+pkgconfig_result = pkgconfig.parse('libavformat libswscale')
 
 print("Numpy dir: ", np.get_include())
 
@@ -19,7 +19,11 @@ mvextractor = Extension('mvextractor.videocap',
         'src/mvextractor/py_video_cap.cpp',
         'src/mvextractor/video_cap.cpp',
         'src/mvextractor/time_cvt.cpp',
-        'src/mvextractor/mat_to_ndarray.cpp'
+        'src/mvextractor/stream_info_cache.cpp',
+        'src/mvextractor/video_index.cpp',
+        'src/mvextractor/sliced_scaler.cpp',
+        'src/mvextractor/motion_vectors.cpp',
+        'src/mvextractor/buffer_pool.cpp'
     ],
     extra_compile_args = ['-std=c++11'],
     extra_link_args = ['-fPIC', '-Wl,-Bsymbolic'])
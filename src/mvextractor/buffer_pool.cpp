@@ -0,0 +1,121 @@
+#include "buffer_pool.hpp"
+
+#include <cstdlib>
+
+
+// each buffer is preceded by a header which stores its bucket, the header
+// size keeps the alignment of malloc
+struct BufferHeader
+{
+    int64_t bucket;
+    int64_t reserved;
+};
+
+static_assert(sizeof(BufferHeader) == 16, "unexpected size of BufferHeader");
+
+
+static BufferHeader *get_header(void *buffer) {
+    return (BufferHeader *)buffer - 1;
+}
+
+
+static void *allocate_buffer(size_t size, int bucket) {
+    BufferHeader *header = (BufferHeader *)malloc(sizeof(BufferHeader) + size);
+    if (header == NULL)
+        return NULL;
+    header->bucket = bucket;
+    header->reserved = 0;
+    return header + 1;
+}
+
+
+static void free_buffer(void *buffer) {
+    free(get_header(buffer));
+}
+
+
+BufferPool::BufferPool(size_t max_cached_per_bucket) {
+    this->max_cached_per_bucket = max_cached_per_bucket;
+    this->buckets.resize(bucket_index(max_pooled_size) + 1);
+}
+
+
+BufferPool::~BufferPool() {
+    this->clear();
+}
+
+
+int BufferPool::bucket_index(size_t size) {
+    if (size > max_pooled_size)
+        return -1;
+
+    int index = 0;
+    for (size_t capacity = min_pooled_size; capacity < size; capacity *= 2)
+        index++;
+    return index;
+}
+
+
+void *BufferPool::acquire(size_t size) {
+    int bucket = bucket_index(size);
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (bucket >= 0 && !this->buckets[bucket].empty()) {
+            void *buffer = this->buckets[bucket].back();
+            this->buckets[bucket].pop_back();
+            this->stats.hits++;
+            this->stats.cached_buffers--;
+            this->stats.cached_bytes -= min_pooled_size << bucket;
+            return buffer;
+        }
+        this->stats.misses++;
+    }
+
+    // allocate outside of the lock, buffers of a bucket have the full capacity of the bucket
+    return allocate_buffer(bucket >= 0 ? (min_pooled_size << bucket) : size, bucket);
+}
+
+
+void BufferPool::release(void *buffer) {
+    if (buffer == NULL)
+        return;
+
+    int64_t bucket = get_header(buffer)->bucket;
+    if (bucket >= 0) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if (this->buckets[bucket].size() < this->max_cached_per_bucket) {
+            this->buckets[bucket].push_back(buffer);
+            this->stats.cached_buffers++;
+            this->stats.cached_bytes += min_pooled_size << bucket;
+            return;
+        }
+    }
+
+    free_buffer(buffer);
+}
+
+
+void BufferPool::clear(void) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    for (std::vector<void *> &bucket : this->buckets) {
+        for (void *buffer : bucket)
+            free_buffer(buffer);
+        bucket.clear();
+    }
+    this->stats.cached_buffers = 0;
+    this->stats.cached_bytes = 0;
+}
+
+
+BufferPoolStats BufferPool::get_stats(void) {
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->stats;
+}
+
+
+BufferPool &motion_vector_pool(void) {
+    // never destroyed, arrays may release their buffers during interpreter shutdown
+    static BufferPool *pool = new BufferPool();
+    return *pool;
+}
@@ -0,0 +1,81 @@
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <cstddef>
+
+
+/**
+* Counters of a `BufferPool`.
+*/
+struct BufferPoolStats
+{
+    /** Number of buffers which were taken from the pool */
+    uint64_t hits = 0;
+
+    /** Number of buffers which had to be allocated, because the pool had no
+    *   free buffer of the requested size */
+    uint64_t misses = 0;
+
+    /** Number of free buffers currently held by the pool */
+    uint64_t cached_buffers = 0;
+
+    /** Total size in bytes of the free buffers currently held by the pool */
+    uint64_t cached_bytes = 0;
+};
+
+
+/**
+* Thread-safe pool of heap buffers, which avoids a malloc and free per frame
+* for motion vector arrays.
+*
+* Buffers are bucketed by capacity in powers of two. `acquire` returns a
+* free buffer of the smallest sufficient bucket or allocates a new one,
+* `release` returns a buffer into its bucket. Each bucket keeps at most
+* `max_cached_per_bucket` free buffers, further released buffers are freed.
+* Requests larger than `max_pooled_size` bypass the pool.
+*/
+class BufferPool
+{
+public:
+    /** Capacity of the smallest bucket in bytes */
+    static const size_t min_pooled_size = 4096;
+
+    /** Capacity of the largest bucket in bytes */
+    static const size_t max_pooled_size = 64 * 1024 * 1024;
+
+    BufferPool(size_t max_cached_per_bucket = 64);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    /** Returns a buffer of at least `size` bytes, which must be returned with
+    *   `release`, or NULL if memory could not be allocated. Buffers are 16
+    *   byte aligned. */
+    void *acquire(size_t size);
+
+    /** Returns a buffer obtained from `acquire` to the pool. Does nothing if
+    *   `buffer` is NULL. */
+    void release(void *buffer);
+
+    /** Frees all free buffers held by the pool */
+    void clear(void);
+
+    BufferPoolStats get_stats(void);
+
+private:
+    std::mutex mutex;
+    size_t max_cached_per_bucket;
+    std::vector<std::vector<void *>> buckets;
+    BufferPoolStats stats;
+
+    /** Returns the bucket of the given size, or -1 if it is not pooled */
+    static int bucket_index(size_t size);
+};
+
+
+/**
+* Returns the process-wide pool for motion vector buffers, which is shared by
+* all `VideoCap` objects.
+*/
+BufferPool &motion_vector_pool(void);
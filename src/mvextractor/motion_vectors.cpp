@@ -0,0 +1,148 @@
+#include "motion_vectors.hpp"
+
+#include <cstddef>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define MVS_HAVE_SSE41
+#include <smmintrin.h>
+#endif
+
+
+#ifdef MVS_HAVE_SSE41
+
+// the shuffles below depend on the field offsets of AVMotionVector
+static_assert(sizeof(AVMotionVector) == 40, "unexpected size of AVMotionVector");
+static_assert(offsetof(AVMotionVector, w) == 4 && offsetof(AVMotionVector, h) == 5, "unexpected layout of AVMotionVector");
+static_assert(offsetof(AVMotionVector, src_x) == 6 && offsetof(AVMotionVector, dst_y) == 12, "unexpected layout of AVMotionVector");
+static_assert(offsetof(AVMotionVector, motion_x) == 24 && offsetof(AVMotionVector, motion_scale) == 32, "unexpected layout of AVMotionVector");
+
+
+/** Converts one motion vector into three vectors holding fields 0-3, 4-7 and 8-9 */
+__attribute__((target("sse4.1")))
+static inline void unpack_motion_vector_sse41(const AVMotionVector *mv, __m128i *out0, __m128i *out1, __m128i *out2) {
+
+    // byte 0-3 source, 4 w, 5 h, 6-7 src_x, 8-9 src_y, 10-11 dst_x, 12-13 dst_y
+    __m128i head = _mm_loadu_si128((const __m128i *)mv);
+    // byte 0-3 motion_x, 4-7 motion_y, 8-9 motion_scale, the load ends with the struct
+    __m128i tail = _mm_loadu_si128((const __m128i *)((const uint8_t *)mv + 24));
+
+    const __m128i zero_extend_head = _mm_setr_epi8(0, 1, 2, 3, 4, -1, -1, -1, 5, -1, -1, -1, -1, -1, -1, -1);
+    // the int16 fields are moved into the upper half of each lane and sign extended by the shift
+    const __m128i src_x_high = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 6, 7);
+    const __m128i int16_high = _mm_setr_epi8(-1, -1, 8, 9, -1, -1, 10, 11, -1, -1, 12, 13, -1, -1, -1, -1);
+    const __m128i zero_extend_tail = _mm_setr_epi8(4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+
+    // source, w, h, src_x
+    __m128i src_x = _mm_srai_epi32(_mm_shuffle_epi8(head, src_x_high), 16);
+    *out0 = _mm_blend_epi16(_mm_shuffle_epi8(head, zero_extend_head), src_x, 0xC0);
+
+    // src_y, dst_x, dst_y, motion_x
+    __m128i coords = _mm_srai_epi32(_mm_shuffle_epi8(head, int16_high), 16);
+    *out1 = _mm_blend_epi16(coords, _mm_shuffle_epi32(tail, 0x00), 0xC0);
+
+    // motion_y, motion_scale
+    *out2 = _mm_shuffle_epi8(tail, zero_extend_tail);
+}
+
+
+/** Stores the transpose of four vectors with four lanes each into four rows `stride` elements apart */
+__attribute__((target("sse4.1")))
+static inline void store_transposed_sse41(int32_t *dst, int64_t stride, __m128i a, __m128i b, __m128i c, __m128i d, int rows) {
+    __m128i ab_low = _mm_unpacklo_epi32(a, b);
+    __m128i cd_low = _mm_unpacklo_epi32(c, d);
+    __m128i ab_high = _mm_unpackhi_epi32(a, b);
+    __m128i cd_high = _mm_unpackhi_epi32(c, d);
+
+    _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi64(ab_low, cd_low));
+    _mm_storeu_si128((__m128i *)(dst + stride), _mm_unpackhi_epi64(ab_low, cd_low));
+    if (rows > 2) {
+        _mm_storeu_si128((__m128i *)(dst + 2 * stride), _mm_unpacklo_epi64(ab_high, cd_high));
+        _mm_storeu_si128((__m128i *)(dst + 3 * stride), _mm_unpackhi_epi64(ab_high, cd_high));
+    }
+}
+
+
+/** Returns the number of motion vectors which were packed, the rest is left to the scalar code */
+__attribute__((target("sse4.1")))
+static int64_t pack_motion_vectors_sse41(const AVMotionVector *mvs, int64_t n, int32_t *dst, MotionVectorLayout layout, int64_t capacity) {
+    __m128i out0[4], out1[4], out2[4];
+    int64_t i = 0;
+
+    if (layout == MVS_LAYOUT_SOA) {
+        // four motion vectors at a time, so that each field is stored as a whole vector
+        for (; i + 4 <= n; i += 4) {
+            for (int j = 0; j < 4; j++)
+                unpack_motion_vector_sse41(&mvs[i + j], &out0[j], &out1[j], &out2[j]);
+            store_transposed_sse41(dst + i, capacity, out0[0], out0[1], out0[2], out0[3], 4);
+            store_transposed_sse41(dst + 4 * capacity + i, capacity, out1[0], out1[1], out1[2], out1[3], 4);
+            store_transposed_sse41(dst + 8 * capacity + i, capacity, out2[0], out2[1], out2[2], out2[3], 2);
+        }
+    }
+    else {
+        for (; i < n; i++) {
+            unpack_motion_vector_sse41(&mvs[i], &out0[0], &out1[0], &out2[0]);
+            int32_t *row = dst + i * 10;
+            _mm_storeu_si128((__m128i *)row, out0[0]);
+            _mm_storeu_si128((__m128i *)(row + 4), out1[0]);
+            _mm_storel_epi64((__m128i *)(row + 8), out2[0]);
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+
+template <>
+void pack_motion_vectors<int32_t>(const AVMotionVector *mvs, int64_t n, int32_t *dst, MotionVectorLayout layout, int64_t capacity) {
+    int64_t i = 0;
+
+#ifdef MVS_HAVE_SSE41
+    static const bool has_sse41 = __builtin_cpu_supports("sse4.1");
+    if (has_sse41)
+        i = pack_motion_vectors_sse41(mvs, n, dst, layout, capacity);
+#endif
+
+    // remaining motion vectors, or all of them without SSE4.1
+    if (layout == MVS_LAYOUT_SOA) {
+        for (; i < n; i++)
+            pack_motion_vector(mvs[i], dst + i, capacity);
+    }
+    else {
+        for (; i < n; i++)
+            pack_motion_vector(mvs[i], dst + i * 10, 1);
+    }
+}
+
+
+template <>
+void pack_motion_vectors<PackedMotionVector>(const AVMotionVector *mvs, int64_t n, PackedMotionVector *dst, MotionVectorLayout layout, int64_t capacity) {
+    for (int64_t i = 0; i < n; i++) {
+        dst[i].source = static_cast<int8_t>(mvs[i].source);
+        dst[i].w = mvs[i].w;
+        dst[i].h = mvs[i].h;
+        dst[i].src_x = mvs[i].src_x;
+        dst[i].src_y = mvs[i].src_y;
+        dst[i].dst_x = mvs[i].dst_x;
+        dst[i].dst_y = mvs[i].dst_y;
+        dst[i].motion_x = static_cast<int16_t>(mvs[i].motion_x);
+        dst[i].motion_y = static_cast<int16_t>(mvs[i].motion_y);
+        dst[i].motion_scale = static_cast<uint8_t>(mvs[i].motion_scale);
+    }
+}
+
+
+void pack_motion_vectors(const AVMotionVector *mvs, int64_t n, void *dst, MotionVectorDtype dtype, MotionVectorLayout layout, int64_t capacity) {
+    switch (dtype) {
+        case MVS_DTYPE_INT16:
+            pack_motion_vectors(mvs, n, (int16_t *)dst, layout, capacity);
+            break;
+        case MVS_DTYPE_PACKED:
+            pack_motion_vectors(mvs, n, (PackedMotionVector *)dst, MVS_LAYOUT_AOS, capacity);
+            break;
+        default:
+            pack_motion_vectors(mvs, n, (int32_t *)dst, layout, capacity);
+            break;
+    }
+}
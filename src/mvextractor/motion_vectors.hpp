@@ -0,0 +1,137 @@
+#include <cstdint>
+#include <cstddef>
+
+extern "C" {
+#include <libavutil/motion_vector.h>
+}
+
+
+/**
+* Memory layouts of the motion vector arrays returned by `VideoCap`.
+*
+* - MVS_LAYOUT_AOS: Array of structures of shape (num_mvs, 10). Each row
+*       contains the fields of one motion vector in the order source, w, h,
+*       src_x, src_y, dst_x, dst_y, motion_x, motion_y, motion_scale.
+* - MVS_LAYOUT_SOA: Structure of arrays of shape (10, num_mvs). Each row
+*       contains one field of all motion vectors in the same order as the
+*       columns of MVS_LAYOUT_AOS, e.g. row 5 contains dst_x of all motion
+*       vectors. Every field is contiguous in memory.
+*/
+enum MotionVectorLayout
+{
+    MVS_LAYOUT_AOS,
+    MVS_LAYOUT_SOA
+};
+
+
+/**
+* Element types of the motion vector arrays returned by `VideoCap`.
+*
+* - MVS_DTYPE_INT32: 10 int32 values per motion vector (40 bytes), which
+*       hold all fields without loss.
+* - MVS_DTYPE_INT16: 10 int16 values per motion vector (20 bytes). All
+*       fields fit into int16, except for motion_x and motion_y of vectors
+*       longer than 8191 pixels at quarter pixel precision.
+* - MVS_DTYPE_PACKED: One `PackedMotionVector` per motion vector (16 bytes)
+*       with the same value ranges as MVS_DTYPE_INT16. Only available in
+*       the MVS_LAYOUT_AOS layout.
+*/
+enum MotionVectorDtype
+{
+    MVS_DTYPE_INT32,
+    MVS_DTYPE_INT16,
+    MVS_DTYPE_PACKED
+};
+
+
+#pragma pack(push, 1)
+/** Motion vector with the smallest types which hold the values of each field */
+struct PackedMotionVector
+{
+    int8_t source;
+    uint8_t w;
+    uint8_t h;
+    int16_t src_x;
+    int16_t src_y;
+    int16_t dst_x;
+    int16_t dst_y;
+    int16_t motion_x;
+    int16_t motion_y;
+    uint8_t motion_scale;
+};
+#pragma pack(pop)
+
+
+/** Returns the size of one motion vector in bytes */
+inline size_t motion_vector_size(MotionVectorDtype dtype) {
+    switch (dtype) {
+        case MVS_DTYPE_INT16:
+            return 10 * sizeof(int16_t);
+        case MVS_DTYPE_PACKED:
+            return sizeof(PackedMotionVector);
+        default:
+            return 10 * sizeof(int32_t);
+    }
+}
+
+
+/** Stores the fields of a single motion vector, `field_stride` elements apart */
+template <typename T>
+inline void pack_motion_vector(const AVMotionVector &mv, T *dst, int64_t field_stride) {
+    dst[0               ] = static_cast<T>(mv.source);
+    dst[    field_stride] = static_cast<T>(mv.w);
+    dst[2 * field_stride] = static_cast<T>(mv.h);
+    dst[3 * field_stride] = static_cast<T>(mv.src_x);
+    dst[4 * field_stride] = static_cast<T>(mv.src_y);
+    dst[5 * field_stride] = static_cast<T>(mv.dst_x);
+    dst[6 * field_stride] = static_cast<T>(mv.dst_y);
+    dst[7 * field_stride] = static_cast<T>(mv.motion_x);
+    dst[8 * field_stride] = static_cast<T>(mv.motion_y);
+    dst[9 * field_stride] = static_cast<T>(mv.motion_scale);
+}
+
+
+/**
+* Converts motion vectors exported by FFmpeg into a motion vector array.
+*
+* @param mvs Motion vectors as found in the `AV_FRAME_DATA_MOTION_VECTORS`
+*    side data of a frame.
+*
+* @param n Number of motion vectors to convert.
+*
+* @param dst Destination array, see `MotionVectorLayout`.
+*
+* @param layout Memory layout of `dst`.
+*
+* @param capacity Number of motion vectors which fit into `dst`, at least
+*    `n`. For MVS_LAYOUT_SOA this is the distance between two fields in
+*    elements, i.e. `dst` has shape (10, capacity). Unused for MVS_LAYOUT_AOS.
+*/
+template <typename T>
+void pack_motion_vectors(const AVMotionVector *mvs, int64_t n, T *dst, MotionVectorLayout layout, int64_t capacity) {
+    if (layout == MVS_LAYOUT_SOA) {
+        for (int64_t i = 0; i < n; i++)
+            pack_motion_vector(mvs[i], dst + i, capacity);
+    }
+    else {
+        for (int64_t i = 0; i < n; i++)
+            pack_motion_vector(mvs[i], dst + i * 10, 1);
+    }
+}
+
+
+/** Vectorized version for int32 arrays, which uses SSE4.1 if the CPU supports it */
+template <>
+void pack_motion_vectors<int32_t>(const AVMotionVector *mvs, int64_t n, int32_t *dst, MotionVectorLayout layout, int64_t capacity);
+
+
+/** Version for packed motion vectors, which are always stored in MVS_LAYOUT_AOS */
+template <>
+void pack_motion_vectors<PackedMotionVector>(const AVMotionVector *mvs, int64_t n, PackedMotionVector *dst, MotionVectorLayout layout, int64_t capacity);
+
+
+/**
+* Converts motion vectors into an array of the given element type. Calls
+* the `pack_motion_vectors` template for the type.
+*/
+void pack_motion_vectors(const AVMotionVector *mvs, int64_t n, void *dst, MotionVectorDtype dtype, MotionVectorLayout layout, int64_t capacity);
@@ -0,0 +1,189 @@
+import os
+import collections
+import tempfile
+from concurrent.futures import ThreadPoolExecutor
+
+from mvextractor.videocap import VideoCap, build_index, empty_motion_vectors
+
+
+class ParallelVideoCap:
+    """Decodes a single video file with several decoders in parallel.
+
+    The video is split at keyframes into shards of whole GOPs. Each shard is
+    decoded by its own VideoCap in a pool of worker threads, which run in
+    parallel because VideoCap releases the GIL while decoding. Frames and
+    motion vectors are returned in display order, exactly as a single VideoCap
+    would return them. Timestamps default to the presentation time of the
+    frames (timestamp_source "pts"), because the system time would only tell
+    when a worker happened to decode a frame.
+
+    Splitting requires the keyframe positions from the index sidecar of the
+    video (see build_index). If the sidecar does not exist or is stale, an
+    index is built in a temporary directory when opening the video.
+
+    Only video files are supported, not live streams.
+    """
+
+    def __init__(self, num_workers=None, shard_frames=250, max_pending_shards=None):
+        """
+        num_workers: number of decoder threads, defaults to the number of CPU cores.
+        shard_frames: minimum number of frames per shard. Shards consist of
+            whole GOPs, so they are usually larger.
+        max_pending_shards: maximum number of shards which are decoded ahead
+            of the shard being read. Each pending shard holds all of its
+            frames in memory, e.g. about 1.5 GB for 250 frames of 1080p
+            video. Defaults to one more than the number of workers, so that
+            every worker is busy while the oldest shard is being read.
+        """
+        self.num_workers = num_workers or os.cpu_count() or 1
+        self.shard_frames = max(1, shard_frames)
+        self.max_pending_shards = max_pending_shards or self.num_workers + 1
+        self.executor = None
+        self.tmp_dir = None
+        self._reset()
+
+
+    def _reset(self):
+        self.url = None
+        self.index_path = None
+        self.open_kwargs = {}
+        self.empty_motion_vectors = empty_motion_vectors()
+        self.shards = collections.deque()
+        self.pending = collections.deque()
+        self.buffer = collections.deque()
+        self.current_frame_number = -1
+
+
+    def open(self, url, index_path=None, **kwargs):
+        """Opens a video file. Takes the same keyword arguments as VideoCap.open().
+
+        Each worker uses a single decoder thread unless `thread_count` is given.
+        Timestamps are presentation times unless `timestamp_source` is given.
+        Returns True if the video could be opened and split, False otherwise.
+        """
+        self.release()
+
+        kwargs.setdefault("thread_count", 1)
+        kwargs.setdefault("timestamp_source", "pts")
+
+        # use the sidecar next to the video if it is valid, otherwise build a temporary one
+        if index_path is None:
+            index_path = url + ".mvidx"
+        frame_count, keyframes = self._read_index(url, index_path, kwargs)
+        if len(keyframes) == 0:
+            self.tmp_dir = tempfile.TemporaryDirectory()
+            index_path = os.path.join(self.tmp_dir.name, os.path.basename(url) + ".mvidx")
+            if not build_index(url, index_path=index_path):
+                self.release()
+                return False
+            frame_count, keyframes = self._read_index(url, index_path, kwargs)
+        if frame_count <= 0 or len(keyframes) == 0:
+            self.release()
+            return False
+
+        self.url = url
+        self.index_path = index_path
+        self.open_kwargs = kwargs
+        # returned at the end of the video, with the dtype and layout of the configured motion vectors
+        self.empty_motion_vectors = empty_motion_vectors(
+            mvs_layout=kwargs.get("mvs_layout", "aos"), mvs_dtype=kwargs.get("mvs_dtype", "int32"))
+        self.shards.extend(self._split(keyframes, frame_count))
+
+        self.executor = ThreadPoolExecutor(max_workers=self.num_workers)
+        self._submit_shards()
+        return True
+
+
+    def _read_index(self, url, index_path, kwargs):
+        # keyframes are empty if the index is missing, stale or invalid, as VideoCap ignores it then
+        cap = VideoCap()
+        try:
+            if not cap.open(url, index_path=index_path, **kwargs):
+                return -1, []
+            return cap.frame_count(), cap.keyframes().tolist()
+        finally:
+            cap.release()
+
+
+    def _split(self, keyframes, frame_count):
+        # group consecutive GOPs into shards of at least shard_frames frames
+        shards = []
+        start = 0
+        for keyframe in keyframes[1:] + [frame_count]:
+            if keyframe - start >= self.shard_frames or keyframe == frame_count:
+                shards.append((start, keyframe))
+                start = keyframe
+        return shards
+
+
+    def _submit_shards(self):
+        while self.shards and len(self.pending) < self.max_pending_shards:
+            start, end = self.shards.popleft()
+            self.pending.append(self.executor.submit(self._decode_shard, start, end))
+
+
+    def _decode_shard(self, start, end):
+        cap = VideoCap()
+        try:
+            if not cap.open(self.url, index_path=self.index_path, **self.open_kwargs):
+                raise RuntimeError(f"Could not open {self.url}")
+            if not cap.seek(start):
+                raise RuntimeError(f"Could not seek to frame {start} of {self.url}")
+
+            # the decoder outputs frames in display order, the shard ends at the next shard's keyframe
+            results = []
+            while True:
+                ret, frame, motion_vectors, frame_type, timestamp = cap.read()
+                if not ret:
+                    break
+                frame_number = cap.frame_number()
+                if frame_number >= end:
+                    break
+                results.append((frame_number, frame, motion_vectors, frame_type, timestamp))
+            return results
+        finally:
+            cap.release()
+
+
+    def read(self):
+        """Returns the next frame and motion vectors like VideoCap.read().
+
+        Raises a RuntimeError if a shard could not be decoded.
+        """
+        while not self.buffer and self.pending:
+            shard = self.pending.popleft()
+            self._submit_shards()
+            self.buffer.extend(shard.result())
+
+        if not self.buffer:
+            return False, None, self.empty_motion_vectors, "?", 0.0
+
+        frame_number, frame, motion_vectors, frame_type, timestamp = self.buffer.popleft()
+        self.current_frame_number = frame_number
+        return True, frame, motion_vectors, frame_type, timestamp
+
+
+    def frame_number(self):
+        """Returns the index of the last frame returned by read(), -1 before the first frame."""
+        return self.current_frame_number
+
+
+    def __iter__(self):
+        while True:
+            ret, frame, motion_vectors, frame_type, timestamp = self.read()
+            if not ret:
+                return
+            yield frame, motion_vectors, frame_type, timestamp
+
+
+    def release(self):
+        """Stops all workers and releases all resources."""
+        if self.executor is not None:
+            for shard in self.pending:
+                shard.cancel()
+            self.executor.shutdown(wait=True)
+            self.executor = None
+        if self.tmp_dir is not None:
+            self.tmp_dir.cleanup()
+            self.tmp_dir = None
+        self._reset()
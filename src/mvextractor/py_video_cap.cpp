@@ -1,35 +1,412 @@
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <numpy/arrayobject.h>
-#include <opencv2/core/core.hpp>
+#include <new>
 
 #include "video_cap.hpp"
-#include "mat_to_ndarray.hpp"
+#include "buffer_pool.hpp"
 
 typedef struct {
     PyObject_HEAD
     VideoCap vcap;
-    //NDArrayConverter mat_to_ndarray_cvt;
+    // serializes access to vcap while the GIL is released
+    PyThread_type_lock lock;
 } VideoCapObject;
 
 
+static PyObject *
+VideoCap_new(PyTypeObject *type, PyObject *Py_UNUSED(args), PyObject *Py_UNUSED(kwds))
+{
+    VideoCapObject *self = (VideoCapObject *) type->tp_alloc(type, 0);
+    if (self == NULL)
+        return NULL;
+
+    new (&(self->vcap)) VideoCap();
+
+    self->lock = PyThread_allocate_lock();
+    if (self->lock == NULL) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+
+    return (PyObject *) self;
+}
+
+
 static void
 VideoCap_dealloc(VideoCapObject *self)
 {
     self->vcap.release();
+    self->vcap.~VideoCap();
+    if (self->lock != NULL)
+        PyThread_free_lock(self->lock);
     Py_TYPE(self)->tp_free((PyObject *) self);
 }
 
 
+// Acquires the lock of the object. If another thread is decoding with this
+// object, the GIL is released while waiting for it to finish.
+static void
+VideoCap_lock(VideoCapObject *self)
+{
+    if (!PyThread_acquire_lock(self->lock, NOWAIT_LOCK)) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+}
+
+
+static void
+VideoCap_unlock(VideoCapObject *self)
+{
+    PyThread_release_lock(self->lock);
+}
+
+
+// Maps the name of a decode profile to the corresponding enum value
+static bool
+parse_decode_profile(const char *name, DecodeProfile *decode_profile)
+{
+    if (strcmp(name, "full") == 0)
+        *decode_profile = DECODE_PROFILE_FULL;
+    else if (strcmp(name, "mvs") == 0)
+        *decode_profile = DECODE_PROFILE_MVS;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid decode_profile '%s', must be 'full' or 'mvs'", name);
+        return false;
+    }
+    return true;
+}
+
+
+// Maps the name of an output pixel format to the corresponding FFMPEG pixel format
+static bool
+parse_output_format(const char *name, AVPixelFormat *output_format)
+{
+    if (strcmp(name, "bgr24") == 0)
+        *output_format = AV_PIX_FMT_BGR24;
+    else if (strcmp(name, "rgb24") == 0)
+        *output_format = AV_PIX_FMT_RGB24;
+    else if (strcmp(name, "gray") == 0)
+        *output_format = AV_PIX_FMT_GRAY8;
+    else if (strcmp(name, "nv12") == 0)
+        *output_format = AV_PIX_FMT_NV12;
+    else if (strcmp(name, "yuv420p") == 0)
+        *output_format = AV_PIX_FMT_YUV420P;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid output_format '%s', must be 'bgr24', 'rgb24', 'gray', 'nv12' or 'yuv420p'", name);
+        return false;
+    }
+    return true;
+}
+
+
+// Maps the name of a scaling algorithm to the corresponding libswscale flag
+static bool
+parse_scaler(const char *name, int *scaler)
+{
+    if (strcmp(name, "fast_bilinear") == 0)
+        *scaler = SWS_FAST_BILINEAR;
+    else if (strcmp(name, "bilinear") == 0)
+        *scaler = SWS_BILINEAR;
+    else if (strcmp(name, "bicubic") == 0)
+        *scaler = SWS_BICUBIC;
+    else if (strcmp(name, "point") == 0)
+        *scaler = SWS_POINT;
+    else if (strcmp(name, "area") == 0)
+        *scaler = SWS_AREA;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid scaler '%s', must be 'fast_bilinear', 'bilinear', 'bicubic', 'point' or 'area'", name);
+        return false;
+    }
+    return true;
+}
+
+
+// Maps the name of a motion vector layout to the corresponding enum value
+static bool
+parse_mvs_layout(const char *name, MotionVectorLayout *layout)
+{
+    if (strcmp(name, "aos") == 0)
+        *layout = MVS_LAYOUT_AOS;
+    else if (strcmp(name, "soa") == 0)
+        *layout = MVS_LAYOUT_SOA;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid mvs_layout '%s', must be 'aos' or 'soa'", name);
+        return false;
+    }
+    return true;
+}
+
+
+// Maps the name of a motion vector dtype to the corresponding enum value
+static bool
+parse_mvs_dtype(const char *name, MotionVectorDtype *dtype)
+{
+    if (strcmp(name, "int32") == 0)
+        *dtype = MVS_DTYPE_INT32;
+    else if (strcmp(name, "int16") == 0)
+        *dtype = MVS_DTYPE_INT16;
+    else if (strcmp(name, "packed") == 0)
+        *dtype = MVS_DTYPE_PACKED;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid mvs_dtype '%s', must be 'int32', 'int16' or 'packed'", name);
+        return false;
+    }
+    return true;
+}
+
+
+// Maps the name of a timestamp source to the corresponding enum value
+static bool
+parse_timestamp_source(const char *name, TimestampSource *source)
+{
+    if (strcmp(name, "system") == 0)
+        *source = TIMESTAMP_SOURCE_SYSTEM;
+    else if (strcmp(name, "pts") == 0)
+        *source = TIMESTAMP_SOURCE_PTS;
+    else if (strcmp(name, "creation_time") == 0)
+        *source = TIMESTAMP_SOURCE_CREATION_TIME;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid timestamp_source '%s', must be 'system', 'pts' or 'creation_time'", name);
+        return false;
+    }
+    return true;
+}
+
+
+// Returns a new reference to the numpy dtype of motion vector arrays. The
+// structured dtype of packed motion vectors matches PackedMotionVector.
+static PyArray_Descr *
+mvs_descr(MotionVectorDtype dtype)
+{
+    static PyArray_Descr *packed_descr = NULL;
+
+    if (dtype == MVS_DTYPE_INT32)
+        return PyArray_DescrFromType(NPY_INT32);
+    if (dtype == MVS_DTYPE_INT16)
+        return PyArray_DescrFromType(NPY_INT16);
+
+    if (packed_descr == NULL) {
+        PyObject *fields = Py_BuildValue("[(ss)(ss)(ss)(ss)(ss)(ss)(ss)(ss)(ss)(ss)]",
+            "source", "i1", "w", "u1", "h", "u1", "src_x", "i2", "src_y", "i2",
+            "dst_x", "i2", "dst_y", "i2", "motion_x", "i2", "motion_y", "i2", "motion_scale", "u1");
+        if (fields == NULL)
+            return NULL;
+        int ret = PyArray_DescrConverter(fields, &packed_descr);
+        Py_DECREF(fields);
+        if (!ret)
+            return NULL;
+        if ((size_t)PyDataType_ELSIZE(packed_descr) != sizeof(PackedMotionVector)) {
+            Py_CLEAR(packed_descr);
+            PyErr_SetString(PyExc_RuntimeError, "unexpected size of packed motion vector dtype");
+            return NULL;
+        }
+    }
+
+    Py_INCREF(packed_descr);
+    return packed_descr;
+}
+
+
+// Returns the shape of a motion vector array, which is transposed for the SoA
+// layout and one-dimensional for packed motion vectors
+static int
+mvs_shape(const VideoCapOptions &options, npy_intp num_mvs, npy_intp dims[2])
+{
+    if (options.mvs_dtype == MVS_DTYPE_PACKED) {
+        dims[0] = num_mvs;
+        return 1;
+    }
+    dims[0] = options.mvs_layout == MVS_LAYOUT_SOA ? 10 : num_mvs;
+    dims[1] = options.mvs_layout == MVS_LAYOUT_SOA ? num_mvs : 10;
+    return 2;
+}
+
+
+// Wraps a motion vector buffer allocated with malloc into a numpy array, which
+// takes ownership of the buffer. The buffer is freed if the array could not be created.
+static PyObject *
+mvs_array_from_data(const VideoCapOptions &options, npy_intp num_mvs, void *motion_vectors)
+{
+    PyArray_Descr *descr = mvs_descr(options.mvs_dtype);
+    if (descr == NULL) {
+        free(motion_vectors);
+        return NULL;
+    }
+
+    // without data numpy allocates the array itself, non-zero flags would make it Fortran ordered
+    npy_intp dims[2];
+    int ndim = mvs_shape(options, num_mvs, dims);
+    PyObject *array = PyArray_NewFromDescr(&PyArray_Type, descr, ndim, dims, NULL,
+        motion_vectors, motion_vectors ? NPY_ARRAY_CARRAY : 0, NULL);
+    if (array == NULL) {
+        free(motion_vectors);
+        return NULL;
+    }
+
+    if (motion_vectors != NULL)
+        PyArray_ENABLEFLAGS((PyArrayObject*)array, NPY_ARRAY_OWNDATA);
+    return array;
+}
+
+
+// Returns a motion vector buffer to the pool when the array using it is deallocated
+static void
+mvs_capsule_destructor(PyObject *capsule)
+{
+    motion_vector_pool().release(PyCapsule_GetPointer(capsule, "mvextractor.MotionVectorBuffer"));
+}
+
+
+// Wraps a motion vector buffer of the pool into a numpy array. The array has a
+// capsule as base object, which returns the buffer to the pool once the array
+// and all views of it are deallocated. The buffer is returned immediately if
+// the array could not be created.
+static PyObject *
+mvs_array_from_pool(const VideoCapOptions &options, npy_intp num_mvs, void *motion_vectors)
+{
+    if (motion_vectors == NULL)
+        return mvs_array_from_data(options, num_mvs, NULL);
+
+    PyObject *capsule = PyCapsule_New(motion_vectors, "mvextractor.MotionVectorBuffer", mvs_capsule_destructor);
+    if (capsule == NULL) {
+        motion_vector_pool().release(motion_vectors);
+        return NULL;
+    }
+
+    PyArray_Descr *descr = mvs_descr(options.mvs_dtype);
+    if (descr == NULL) {
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    npy_intp dims[2];
+    int ndim = mvs_shape(options, num_mvs, dims);
+    PyObject *array = PyArray_NewFromDescr(&PyArray_Type, descr, ndim, dims, NULL,
+        motion_vectors, NPY_ARRAY_CARRAY, NULL);
+    if (array == NULL) {
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    // steals the reference to the capsule, also on failure
+    if (PyArray_SetBaseObject((PyArrayObject *)array, capsule) < 0) {
+        Py_DECREF(array);
+        return NULL;
+    }
+
+    return array;
+}
+
+
+// Returns the number of dimensions of frame arrays, frames with a single channel are 2-dimensional
+static int
+frame_ndim(int cn)
+{
+    return cn == 1 ? 2 : 3;
+}
+
+
+// Maps the name of a threading method to the corresponding FFMPEG flags
+static bool
+parse_thread_type(const char *name, int *thread_type)
+{
+    if (strcmp(name, "auto") == 0)
+        *thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+    else if (strcmp(name, "frame") == 0)
+        *thread_type = FF_THREAD_FRAME;
+    else if (strcmp(name, "slice") == 0)
+        *thread_type = FF_THREAD_SLICE;
+    else {
+        PyErr_Format(PyExc_ValueError, "invalid thread_type '%s', must be 'auto', 'frame' or 'slice'", name);
+        return false;
+    }
+    return true;
+}
+
+
 static PyObject *
-VideoCap_open(VideoCapObject *self, PyObject *args)
+VideoCap_open(VideoCapObject *self, PyObject *args, PyObject *kwds)
 {
+    static const char *kwlist[] = {"url", "frames", "decode_profile", "thread_count", "thread_type", "low_latency", "stream_info_cache", "keyframes_only", "skip_nonref", "index_path",
+        "output_format", "output_width", "output_height", "scaler", "scale_threads", "mvs_layout", "mvs_dtype", "timestamp_source", NULL};
     const char *url;
+    int frames = 1;
+    const char *decode_profile = "full";
+    int thread_count = 0;
+    const char *thread_type = "auto";
+    int low_latency = 0;
+    const char *stream_info_cache = NULL;
+    int keyframes_only = 0;
+    int skip_nonref = 0;
+    const char *index_path = NULL;
+    const char *output_format = "bgr24";
+    int output_width = 0;
+    int output_height = 0;
+    const char *scaler = "bicubic";
+    int scale_threads = 1;
+    const char *mvs_layout = "aos";
+    const char *mvs_dtype = "int32";
+    const char *timestamp_source = "system";
+    bool ret;
 
-    if (!PyArg_ParseTuple(args, "s", &url))
-        Py_RETURN_FALSE;
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|psispzppzsiisisss", (char **)kwlist,
+            &url, &frames, &decode_profile, &thread_count, &thread_type, &low_latency, &stream_info_cache,
+            &keyframes_only, &skip_nonref, &index_path, &output_format, &output_width, &output_height, &scaler,
+            &scale_threads, &mvs_layout, &mvs_dtype, &timestamp_source))
+        return NULL;
+
+    if (thread_count < 0) {
+        PyErr_SetString(PyExc_ValueError, "thread_count must not be negative");
+        return NULL;
+    }
+
+    if (output_width < 0 || output_height < 0) {
+        PyErr_SetString(PyExc_ValueError, "output_width and output_height must not be negative");
+        return NULL;
+    }
+
+    if (scale_threads < 0) {
+        PyErr_SetString(PyExc_ValueError, "scale_threads must not be negative");
+        return NULL;
+    }
 
-    if (!self->vcap.open(url))
+    VideoCapOptions options;
+    options.decode_frames = frames;
+    options.thread_count = thread_count;
+    options.low_latency = low_latency;
+    options.keyframes_only = keyframes_only;
+    options.skip_nonref = skip_nonref;
+    if (stream_info_cache)
+        options.stream_info_cache = stream_info_cache;
+    if (index_path)
+        options.index_path = index_path;
+    options.output_width = output_width;
+    options.output_height = output_height;
+    options.scale_threads = scale_threads;
+    if (!parse_decode_profile(decode_profile, &(options.decode_profile)) ||
+        !parse_thread_type(thread_type, &(options.thread_type)) ||
+        !parse_output_format(output_format, &(options.output_format)) ||
+        !parse_scaler(scaler, &(options.scaler)) ||
+        !parse_mvs_layout(mvs_layout, &(options.mvs_layout)) ||
+        !parse_mvs_dtype(mvs_dtype, &(options.mvs_dtype)) ||
+        !parse_timestamp_source(timestamp_source, &(options.timestamp_source)))
+        return NULL;
+
+    if (options.mvs_dtype == MVS_DTYPE_PACKED && options.mvs_layout == MVS_LAYOUT_SOA) {
+        PyErr_SetString(PyExc_ValueError, "mvs_dtype 'packed' can not be combined with mvs_layout 'soa'");
+        return NULL;
+    }
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    ret = self->vcap.open(url, options);
+    Py_END_ALLOW_THREADS
+    VideoCap_unlock(self);
+
+    if (!ret)
         Py_RETURN_FALSE;
 
     Py_RETURN_TRUE;
@@ -38,114 +415,837 @@ VideoCap_open(VideoCapObject *self, PyObject *args)
 static PyObject *
 VideoCap_grab(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
 {
-    if (!self->vcap.grab())
+    bool ret;
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    ret = self->vcap.grab();
+    Py_END_ALLOW_THREADS
+    VideoCap_unlock(self);
+
+    if (!ret)
         Py_RETURN_FALSE;
 
     Py_RETURN_TRUE;
 }
 
 
+// Retrieves the grabbed frame and motion vectors and packs them into a Python tuple.
+// The frame array is allocated first and the color space conversion writes
+// directly into its memory, so that the frame is not copied afterwards.
+// If `with_frame` is false or the stream is opened without frames, only
+// motion vectors, frame type and timestamp are retrieved and the frame is None.
+// Must be called with the lock of the object held.
 static PyObject *
-VideoCap_retrieve(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+VideoCap_build_retrieve_result(VideoCapObject *self, bool grabbed, bool with_frame)
 {
-    cv::Mat frame_cv;
-    uint8_t *frame = NULL;
+    PyObject *frame_nd = NULL;
     int width = 0;
     int height = 0;
-    int step = 0;
     int cn = 0;
 
-    MVS_DTYPE *motion_vectors = NULL;
-    MVS_DTYPE num_mvs = 0;
+    void *motion_vectors = NULL;
+    int64_t num_mvs = 0;
     char frame_type[2] = "?";
 
     double frame_timestamp = 0;
 
-    PyObject *ret = Py_True;
+    bool success = false;
 
-    if (!self->vcap.retrieve(&frame, &step, &width, &height, &cn, frame_type, &motion_vectors, &num_mvs, &frame_timestamp)) {
-        num_mvs = 0;
-        width = 0;
-        height = 0;
-        step = 0;
-        cn = 0;
-        frame_timestamp = 0;
-        ret = Py_False;
+    with_frame = with_frame && self->vcap.get_options().decode_frames;
+
+    if (grabbed && self->vcap.get_frame_shape(&width, &height, &cn)) {
+        uint8_t *frame = NULL;
+        int step = 0;
+
+        if (with_frame) {
+            npy_intp dims_frame[3] = {(npy_intp)height, (npy_intp)width, (npy_intp)cn};
+            frame_nd = PyArray_SimpleNew(frame_ndim(cn), dims_frame, NPY_UINT8);
+            if (frame_nd == NULL)
+                return NULL;
+
+            frame = (uint8_t *)PyArray_DATA((PyArrayObject *)frame_nd);
+            step = (int)PyArray_STRIDE((PyArrayObject *)frame_nd, 0);
+        }
+
+        // motion vector buffers are reused from a pool instead of being allocated for every frame
+        int64_t max_mvs = self->vcap.count_motion_vectors();
+        if (max_mvs > 0) {
+            motion_vectors = motion_vector_pool().acquire(max_mvs * motion_vector_size(self->vcap.get_options().mvs_dtype));
+            if (motion_vectors == NULL) {
+                Py_XDECREF(frame_nd);
+                return PyErr_NoMemory();
+            }
+        }
+
+        Py_BEGIN_ALLOW_THREADS
+        success = self->vcap.retrieve_into(frame, step, frame_type, motion_vectors, max_mvs, &num_mvs, &frame_timestamp);
+        Py_END_ALLOW_THREADS
     }
 
-    // copy frame buffer into new cv::Mat
-    cv::Mat(height, width, CV_MAKETYPE(CV_8U, cn), frame, step).copyTo(frame_cv);
+    if (!success) {
+        Py_CLEAR(frame_nd);
+        motion_vector_pool().release(motion_vectors);
+        motion_vectors = NULL;
+    }
 
-    // convert frame cv::Mat to numpy.ndarray
-    NDArrayConverter cvt;
-    PyObject* frame_nd = cvt.toNDArray(frame_cv);
+    if (frame_nd == NULL) {
+        Py_INCREF(Py_None);
+        frame_nd = Py_None;
+    }
+
+    if (!success) {
+        num_mvs = 0;
+        frame_type[0] = '?';
+        frame_timestamp = 0;
+    }
 
     // convert motion vector buffer into numpy array
-    npy_intp dims_mvs[2] = {(npy_intp)num_mvs, 10};
-    PyObject *motion_vectors_nd = PyArray_SimpleNewFromData(2, dims_mvs, MVS_DTYPE_NP, motion_vectors);
-    PyArray_ENABLEFLAGS((PyArrayObject*)motion_vectors_nd, NPY_ARRAY_OWNDATA);
+    PyObject *motion_vectors_nd = mvs_array_from_pool(self->vcap.get_options(), (npy_intp)num_mvs, motion_vectors);
+    if (motion_vectors_nd == NULL) {
+        Py_DECREF(frame_nd);
+        return NULL;
+    }
 
+    PyObject *ret = success ? Py_True : Py_False;
     return Py_BuildValue("(ONNsd)", ret, frame_nd, motion_vectors_nd, (const char*)frame_type, frame_timestamp);
 }
 
 
+static PyObject *
+VideoCap_retrieve(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    VideoCap_lock(self);
+    PyObject *result = VideoCap_build_retrieve_result(self, true, true);
+    VideoCap_unlock(self);
+    return result;
+}
+
+
 static PyObject *
 VideoCap_read(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
 {
-    cv::Mat frame_cv;
-    uint8_t *frame = NULL;
+    bool grabbed;
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    grabbed = self->vcap.grab();
+    Py_END_ALLOW_THREADS
+    PyObject *result = VideoCap_build_retrieve_result(self, grabbed, true);
+    VideoCap_unlock(self);
+    return result;
+}
+
+
+// Frees the frame reference held by the planes returned by retrieve_yuv()
+static void
+frame_capsule_destructor(PyObject *capsule)
+{
+    AVFrame *frame = (AVFrame *)PyCapsule_GetPointer(capsule, "mvextractor.AVFrame");
+    av_frame_free(&frame);
+}
+
+
+// Wraps the planes of the grabbed frame into read-only numpy arrays without
+// copying them. All arrays share a capsule as base object, which holds a
+// reference to the frame until the last array is garbage collected.
+// Must be called with the lock of the object held.
+static PyObject *
+VideoCap_build_planes(VideoCapObject *self)
+{
+    AVFrame *frame = NULL;
+    FramePlane planes[4];
+    int num_planes = 0;
+
+    if (!self->vcap.ref_frame(&frame, planes, &num_planes)) {
+        Py_RETURN_NONE;
+    }
+
+    PyObject *capsule = PyCapsule_New(frame, "mvextractor.AVFrame", frame_capsule_destructor);
+    if (capsule == NULL) {
+        av_frame_free(&frame);
+        return NULL;
+    }
+
+    PyObject *planes_tuple = PyTuple_New(num_planes);
+    if (planes_tuple == NULL) {
+        Py_DECREF(capsule);
+        return NULL;
+    }
+
+    for (int p = 0; p < num_planes; p++) {
+        const FramePlane *plane = &(planes[p]);
+        int ndim = plane->components > 1 ? 3 : 2;
+        npy_intp dims[3] = {plane->height, plane->width, plane->components};
+        npy_intp strides[3] = {plane->linesize, plane->component_size * plane->components, plane->component_size};
+        int type_num = plane->component_size > 1 ? NPY_UINT16 : NPY_UINT8;
+
+        // without NPY_ARRAY_WRITEABLE the array is read-only, the decoder may still reference the frame
+        PyObject *plane_nd = PyArray_New(&PyArray_Type, ndim, dims, type_num, strides, plane->data, 0, NPY_ARRAY_ALIGNED, NULL);
+        if (plane_nd == NULL) {
+            Py_DECREF(planes_tuple);
+            Py_DECREF(capsule);
+            return NULL;
+        }
+
+        Py_INCREF(capsule);
+        if (PyArray_SetBaseObject((PyArrayObject *)plane_nd, capsule) < 0) {
+            Py_DECREF(plane_nd);
+            Py_DECREF(planes_tuple);
+            Py_DECREF(capsule);
+            return NULL;
+        }
+
+        PyTuple_SET_ITEM(planes_tuple, p, plane_nd);
+    }
+
+    Py_DECREF(capsule);
+    return planes_tuple;
+}
+
+
+// Retrieves the planes of the grabbed frame instead of a converted frame.
+// Must be called with the lock of the object held.
+static PyObject *
+VideoCap_build_retrieve_yuv_result(VideoCapObject *self, bool grabbed)
+{
+    PyObject *result = VideoCap_build_retrieve_result(self, grabbed, false);
+    if (result == NULL)
+        return NULL;
+
+    if (!PyObject_IsTrue(PyTuple_GET_ITEM(result, 0)))
+        return result;
+
+    PyObject *planes = VideoCap_build_planes(self);
+    if (planes == NULL) {
+        Py_DECREF(result);
+        return NULL;
+    }
+
+    // the tuple was just created, so its items can still be replaced
+    PyObject *none = PyTuple_GET_ITEM(result, 1);
+    PyTuple_SET_ITEM(result, 1, planes);
+    Py_DECREF(none);
+    return result;
+}
+
+
+static PyObject *
+VideoCap_retrieve_yuv(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    VideoCap_lock(self);
+    PyObject *result = VideoCap_build_retrieve_yuv_result(self, true);
+    VideoCap_unlock(self);
+    return result;
+}
+
+
+static PyObject *
+VideoCap_read_yuv(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    bool grabbed;
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    grabbed = self->vcap.grab();
+    Py_END_ALLOW_THREADS
+    PyObject *result = VideoCap_build_retrieve_yuv_result(self, grabbed);
+    VideoCap_unlock(self);
+    return result;
+}
+
+
+static PyObject *
+VideoCap_read_mvs(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    bool grabbed;
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    grabbed = self->vcap.grab();
+    Py_END_ALLOW_THREADS
+    PyObject *result = VideoCap_build_retrieve_result(self, grabbed, false);
+    VideoCap_unlock(self);
+
+    if (result == NULL)
+        return NULL;
+
+    // drop the frame, which is always None here
+    PyObject *result_mvs = Py_BuildValue("(OOOO)",
+        PyTuple_GET_ITEM(result, 0), PyTuple_GET_ITEM(result, 2),
+        PyTuple_GET_ITEM(result, 3), PyTuple_GET_ITEM(result, 4));
+    Py_DECREF(result);
+    return result_mvs;
+}
+
+
+static PyObject *
+VideoCap_retrieve_qp(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    int width, height;
+
+    VideoCap_lock(self);
+    if (!self->vcap.get_qp_shape(&width, &height)) {
+        VideoCap_unlock(self);
+        Py_RETURN_NONE;
+    }
+
+    npy_intp dims[2] = {height, width};
+    PyObject *qp_nd = PyArray_SimpleNew(2, dims, NPY_INT8);
+    if (qp_nd == NULL) {
+        VideoCap_unlock(self);
+        return NULL;
+    }
+
+    self->vcap.retrieve_qp((int8_t *)PyArray_DATA((PyArrayObject *)qp_nd), width);
+    VideoCap_unlock(self);
+
+    return qp_nd;
+}
+
+
+static PyObject *
+VideoCap_retrieve_mb_types(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    int width, height;
+
+    VideoCap_lock(self);
+    if (!self->vcap.get_mb_type_shape(&width, &height)) {
+        VideoCap_unlock(self);
+        Py_RETURN_NONE;
+    }
+
+    npy_intp dims[2] = {height, width};
+    PyObject *mb_types_nd = PyArray_SimpleNew(2, dims, NPY_UINT8);
+    if (mb_types_nd == NULL) {
+        VideoCap_unlock(self);
+        return NULL;
+    }
+
+    self->vcap.retrieve_mb_types((uint8_t *)PyArray_DATA((PyArrayObject *)mb_types_nd), width);
+    VideoCap_unlock(self);
+
+    return mb_types_nd;
+}
+
+
+// Checks that `array` is a writeable array of given dtype whose trailing
+// dimensions are C contiguous, so that native code can write into it row by row.
+static bool
+check_output_array(PyArrayObject *array, PyArray_Descr *descr, int ndim, const char *name)
+{
+    if (!PyArray_EquivTypes(PyArray_DESCR(array), descr) || PyArray_NDIM(array) != ndim) {
+        PyErr_Format(PyExc_ValueError, "%s must be a %d-dimensional array of dtype %S", name, ndim, (PyObject *)descr);
+        return false;
+    }
+
+    if (!PyArray_ISWRITEABLE(array)) {
+        PyErr_Format(PyExc_ValueError, "%s must be writeable", name);
+        return false;
+    }
+
+    npy_intp expected_stride = PyArray_ITEMSIZE(array);
+    for (int i = ndim - 1; i > 0; i--) {
+        if (PyArray_STRIDE(array, i) != expected_stride) {
+            PyErr_Format(PyExc_ValueError, "the rows of %s must be C contiguous", name);
+            return false;
+        }
+        expected_stride *= PyArray_DIM(array, i);
+    }
+
+    return true;
+}
+
+
+static PyObject *
+VideoCap_read_into(VideoCapObject *self, PyObject *args)
+{
+    PyObject *frame_obj;
+    PyArrayObject *frame_nd = NULL;
+    PyArrayObject *motion_vectors_nd;
+
+    if (!PyArg_ParseTuple(args, "OO!", &frame_obj, &PyArray_Type, &motion_vectors_nd))
+        return NULL;
+
+    // without frame_out only motion vectors are retrieved
+    if (frame_obj != Py_None) {
+        if (!PyArray_Check(frame_obj)) {
+            PyErr_SetString(PyExc_TypeError, "frame_out must be a numpy array or None");
+            return NULL;
+        }
+        frame_nd = (PyArrayObject *)frame_obj;
+        PyArray_Descr *frame_descr = PyArray_DescrFromType(NPY_UINT8);
+        bool valid = check_output_array(frame_nd, frame_descr, PyArray_NDIM(frame_nd) == 2 ? 2 : 3, "frame_out");
+        Py_DECREF(frame_descr);
+        if (!valid)
+            return NULL;
+    }
+
+    // the options must not change until the frame is retrieved, so they are
+    // checked with the lock held
+    VideoCap_lock(self);
+
+    VideoCapOptions options = self->vcap.get_options();
+    PyArray_Descr *motion_vectors_descr = mvs_descr(options.mvs_dtype);
+    if (motion_vectors_descr == NULL) {
+        VideoCap_unlock(self);
+        return NULL;
+    }
+    npy_intp dims_mvs[2];
+    int ndim_mvs = mvs_shape(options, 0, dims_mvs);
+    bool valid = check_output_array(motion_vectors_nd, motion_vectors_descr, ndim_mvs, "mvs_out");
+    Py_DECREF(motion_vectors_descr);
+    if (!valid) {
+        VideoCap_unlock(self);
+        return NULL;
+    }
+
+    bool soa = options.mvs_layout == MVS_LAYOUT_SOA;
+    if (ndim_mvs == 2 && PyArray_DIM(motion_vectors_nd, soa ? 0 : 1) != 10) {
+        VideoCap_unlock(self);
+        PyErr_SetString(PyExc_ValueError, soa ? "mvs_out must have shape (10, N)" : "mvs_out must have shape (N, 10)");
+        return NULL;
+    }
+
+    uint8_t *frame = frame_nd ? (uint8_t *)PyArray_DATA(frame_nd) : NULL;
+    int step = frame_nd ? (int)PyArray_STRIDE(frame_nd, 0) : 0;
+    void *motion_vectors = PyArray_DATA(motion_vectors_nd);
+    int64_t max_mvs = (int64_t)PyArray_DIM(motion_vectors_nd, (ndim_mvs == 2 && soa) ? 1 : 0);
+
     int width = 0;
     int height = 0;
-    int step = 0;
     int cn = 0;
 
-    MVS_DTYPE *motion_vectors = NULL;
-    MVS_DTYPE num_mvs = 0;
+    int64_t num_mvs = 0;
     char frame_type[2] = "?";
 
     double frame_timestamp = 0;
 
-    PyObject *ret = Py_True;
+    bool success = false;
+
+    Py_BEGIN_ALLOW_THREADS
+    success = self->vcap.grab() && self->vcap.get_frame_shape(&width, &height, &cn);
+    Py_END_ALLOW_THREADS
 
-    if (!self->vcap.read(&frame, &step, &width, &height, &cn, frame_type, &motion_vectors, &num_mvs, &frame_timestamp)) {
+    if (success && frame_nd && options.decode_frames && (
+                    PyArray_NDIM(frame_nd) != frame_ndim(cn) ||
+                    PyArray_DIM(frame_nd, 0) != height ||
+                    PyArray_DIM(frame_nd, 1) != width ||
+                    (frame_ndim(cn) == 3 && PyArray_DIM(frame_nd, 2) != cn))) {
+        // keep the frame, so that it can be read again into an array of the right shape
+        self->vcap.hold_frame();
+        VideoCap_unlock(self);
+        if (frame_ndim(cn) == 3)
+            PyErr_Format(PyExc_ValueError, "frame_out must have shape (%d, %d, %d)", height, width, cn);
+        else
+            PyErr_Format(PyExc_ValueError, "frame_out must have shape (%d, %d)", height, width);
+        return NULL;
+    }
+
+    if (success) {
+        Py_BEGIN_ALLOW_THREADS
+        success = self->vcap.retrieve_into(frame, step, frame_type, motion_vectors, max_mvs, &num_mvs, &frame_timestamp);
+        Py_END_ALLOW_THREADS
+    }
+
+    VideoCap_unlock(self);
+
+    if (!success) {
         num_mvs = 0;
-        width = 0;
-        height = 0;
-        step = 0;
-        cn = 0;
+        frame_type[0] = '?';
         frame_timestamp = 0;
-        ret = Py_False;
     }
 
-    // copy frame buffer into new cv::Mat
-    cv::Mat(height, width, CV_MAKETYPE(CV_8U, cn), frame, step).copyTo(frame_cv);
+    PyObject *ret = success ? Py_True : Py_False;
+    return Py_BuildValue("(Onsd)", ret, (Py_ssize_t)num_mvs, (const char*)frame_type, frame_timestamp);
+}
+
+
+// Reallocates an array which is referenced by nobody else to its first `n` rows
+static bool
+shrink_array(PyArrayObject *array, npy_intp n)
+{
+    npy_intp dims[NPY_MAXDIMS];
+    int ndim = PyArray_NDIM(array);
+    for (int i = 0; i < ndim; i++)
+        dims[i] = PyArray_DIM(array, i);
+    dims[0] = n;
+
+    PyArray_Dims shape = {dims, ndim};
+    PyObject *ret = PyArray_Resize(array, &shape, 0, NPY_CORDER);
+    if (ret == NULL)
+        return false;
+    Py_DECREF(ret);
+    return true;
+}
+
+
+static PyObject *
+VideoCap_read_batch(VideoCapObject *self, PyObject *args)
+{
+    Py_ssize_t n;
+
+    if (!PyArg_ParseTuple(args, "n", &n))
+        return NULL;
+
+    if (n < 0) {
+        PyErr_SetString(PyExc_ValueError, "n must not be negative");
+        return NULL;
+    }
+
+    int width = 0;
+    int height = 0;
+    int cn = 0;
+    bool grabbed = false;
+    bool out_of_memory = false;
 
-    // convert frame cv::Mat to numpy.ndarray
-    NDArrayConverter cvt;
-    PyObject* frame_nd = cvt.toNDArray(frame_cv);
+    VideoCap_lock(self);
+
+    // another thread may reopen the stream as soon as the lock is released,
+    // so all options are taken from this copy
+    VideoCapOptions options = self->vcap.get_options();
+    bool with_frames = options.decode_frames;
+    bool soa = options.mvs_layout == MVS_LAYOUT_SOA;
+    size_t mv_size = motion_vector_size(options.mvs_dtype);
+
+    // empty batches have the same number of dimensions as those of the output format
+    cn = self->vcap.get_frame_channels();
+
+    // the first frame determines the shape of all frames in the batch
+    if (n > 0) {
+        Py_BEGIN_ALLOW_THREADS
+        grabbed = self->vcap.grab() && self->vcap.get_frame_shape(&width, &height, &cn);
+        Py_END_ALLOW_THREADS
+    }
+
+    npy_intp batch_size = grabbed ? (npy_intp)n : 0;
+    npy_intp dims_frames[4] = {batch_size, (npy_intp)height, (npy_intp)width, (npy_intp)cn};
+    npy_intp dims_offsets[1] = {batch_size + 1};
+    npy_intp dims_batch[1] = {batch_size};
+
+    // without frames only a placeholder of zero size is needed
+    if (!with_frames)
+        dims_frames[1] = dims_frames[2] = dims_frames[3] = 0;
+
+    PyArrayObject *frames_nd = (PyArrayObject *)PyArray_SimpleNew(1 + frame_ndim(cn), dims_frames, NPY_UINT8);
+    PyArrayObject *offsets_nd = (PyArrayObject *)PyArray_SimpleNew(1, dims_offsets, NPY_INT64);
+    PyArrayObject *frame_types_nd = (PyArrayObject *)PyArray_New(&PyArray_Type, 1, dims_batch, NPY_STRING, NULL, NULL, 1, 0, NULL);
+    PyArrayObject *timestamps_nd = (PyArrayObject *)PyArray_SimpleNew(1, dims_batch, NPY_FLOAT64);
+
+    if (!frames_nd || !offsets_nd || !frame_types_nd || !timestamps_nd) {
+        if (grabbed)
+            self->vcap.hold_frame();
+        VideoCap_unlock(self);
+        Py_XDECREF(frames_nd);
+        Py_XDECREF(offsets_nd);
+        Py_XDECREF(frame_types_nd);
+        Py_XDECREF(timestamps_nd);
+        return NULL;
+    }
+
+    uint8_t *frames = with_frames ? (uint8_t *)PyArray_DATA(frames_nd) : NULL;
+    npy_intp frame_size = PyArray_STRIDE(frames_nd, 0);
+    int step = (int)PyArray_STRIDE(frames_nd, 1);
+    int64_t *offsets = (int64_t *)PyArray_DATA(offsets_nd);
+    char *frame_types = (char *)PyArray_DATA(frame_types_nd);
+    double *timestamps = (double *)PyArray_DATA(timestamps_nd);
+
+    // motion vectors of all frames are concatenated in a single growing buffer,
+    // in the SoA layout as one block of shape (10, num_mvs) per frame
+    uint8_t *motion_vectors = NULL;
+    size_t total_mvs = 0;
+    size_t max_mvs = 0;
+    npy_intp num_frames = 0;
+
+    offsets[0] = 0;
+
+    Py_BEGIN_ALLOW_THREADS
+    while (num_frames < batch_size) {
+        if (num_frames > 0) {
+            int frame_width = 0;
+            int frame_height = 0;
+            int frame_cn = 0;
+
+            if (!self->vcap.grab() || !self->vcap.get_frame_shape(&frame_width, &frame_height, &frame_cn))
+                break;
+
+            // a frame of different size starts the next batch
+            if (with_frames && (frame_width != width || frame_height != height || frame_cn != cn)) {
+                self->vcap.hold_frame();
+                break;
+            }
+        }
+
+        size_t required_mvs = total_mvs + self->vcap.count_motion_vectors();
+        if (required_mvs > max_mvs) {
+            size_t new_max_mvs = std::max(required_mvs, 2 * max_mvs);
+            uint8_t *new_motion_vectors = (uint8_t *) realloc(motion_vectors, new_max_mvs * mv_size);
+            if (new_motion_vectors == NULL) {
+                self->vcap.hold_frame();
+                out_of_memory = true;
+                break;
+            }
+            motion_vectors = new_motion_vectors;
+            max_mvs = new_max_mvs;
+        }
+
+        char frame_type[2] = "?";
+        int64_t num_mvs = 0;
+        if (!self->vcap.retrieve_into(
+                frames ? frames + num_frames * frame_size : NULL, step, frame_type,
+                motion_vectors + total_mvs * mv_size, (int64_t)((soa ? required_mvs : max_mvs) - total_mvs),
+                &num_mvs, &timestamps[num_frames])) {
+            // keep the frame for the next batch, which ends empty if it fails
+            // again there, so that a broken frame is not held forever
+            if (num_frames > 0)
+                self->vcap.hold_frame();
+            break;
+        }
+
+        total_mvs += num_mvs;
+        frame_types[num_frames] = frame_type[0];
+        offsets[num_frames + 1] = (int64_t)total_mvs;
+        num_frames++;
+    }
+    Py_END_ALLOW_THREADS
+
+    VideoCap_unlock(self);
+
+    if (out_of_memory) {
+        free(motion_vectors);
+        Py_DECREF(frames_nd);
+        Py_DECREF(offsets_nd);
+        Py_DECREF(frame_types_nd);
+        Py_DECREF(timestamps_nd);
+        return PyErr_NoMemory();
+    }
+
+    // merge the blocks of the SoA layout, so that each field of all frames is contiguous
+    if (soa && num_frames > 1 && total_mvs > 0) {
+        uint8_t *merged = (uint8_t *) malloc(total_mvs * mv_size);
+        if (merged == NULL) {
+            free(motion_vectors);
+            Py_DECREF(frames_nd);
+            Py_DECREF(offsets_nd);
+            Py_DECREF(frame_types_nd);
+            Py_DECREF(timestamps_nd);
+            return PyErr_NoMemory();
+        }
+        for (npy_intp i = 0; i < num_frames; i++) {
+            size_t offset = (size_t)offsets[i];
+            size_t count = (size_t)(offsets[i + 1] - offsets[i]);
+            size_t field_size = mv_size / 10;
+            for (size_t field = 0; field < 10; field++)
+                memcpy(merged + (field * total_mvs + offset) * field_size,
+                    motion_vectors + offset * mv_size + field * count * field_size, count * field_size);
+        }
+        free(motion_vectors);
+        motion_vectors = merged;
+    }
 
     // convert motion vector buffer into numpy array
-    npy_intp dims_mvs[2] = {(npy_intp)num_mvs, 10};
-    PyObject *motion_vectors_nd = PyArray_SimpleNewFromData(2, dims_mvs, MVS_DTYPE_NP, motion_vectors);
-    PyArray_ENABLEFLAGS((PyArrayObject*)motion_vectors_nd, NPY_ARRAY_OWNDATA);
+    PyObject *motion_vectors_nd = mvs_array_from_data(options, (npy_intp)total_mvs, motion_vectors);
+    if (motion_vectors_nd == NULL) {
+        Py_DECREF(frames_nd);
+        Py_DECREF(offsets_nd);
+        Py_DECREF(frame_types_nd);
+        Py_DECREF(timestamps_nd);
+        return NULL;
+    }
 
-    return Py_BuildValue("(ONNsd)", ret, frame_nd, motion_vectors_nd, (const char*)frame_type, frame_timestamp);
+    // free the unused tail of the batch, e.g. at the end of the stream, so
+    // that a short batch does not keep the memory of a full one alive
+    if (num_frames < batch_size) {
+        if (!shrink_array(frames_nd, num_frames) || !shrink_array(offsets_nd, num_frames + 1) ||
+            !shrink_array(frame_types_nd, num_frames) || !shrink_array(timestamps_nd, num_frames)) {
+            Py_DECREF(frames_nd);
+            Py_DECREF(motion_vectors_nd);
+            Py_DECREF(offsets_nd);
+            Py_DECREF(frame_types_nd);
+            Py_DECREF(timestamps_nd);
+            return NULL;
+        }
+    }
+
+    PyObject *result = Py_BuildValue("(OOOOO)", with_frames ? (PyObject *)frames_nd : Py_None, motion_vectors_nd, offsets_nd, frame_types_nd, timestamps_nd);
+
+    Py_DECREF(frames_nd);
+    Py_DECREF(motion_vectors_nd);
+    Py_DECREF(offsets_nd);
+    Py_DECREF(frame_types_nd);
+    Py_DECREF(timestamps_nd);
+
+    return result;
+}
+
+
+static PyObject *
+VideoCap_seek(VideoCapObject *self, PyObject *args)
+{
+    long long frame_index;
+    bool ret;
+
+    if (!PyArg_ParseTuple(args, "L", &frame_index))
+        return NULL;
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    ret = self->vcap.seek(frame_index);
+    Py_END_ALLOW_THREADS
+    VideoCap_unlock(self);
+
+    if (!ret)
+        Py_RETURN_FALSE;
+
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+VideoCap_seek_time(VideoCapObject *self, PyObject *args)
+{
+    double seconds;
+    bool ret;
+
+    if (!PyArg_ParseTuple(args, "d", &seconds))
+        return NULL;
+
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
+    ret = self->vcap.seek_time(seconds);
+    Py_END_ALLOW_THREADS
+    VideoCap_unlock(self);
+
+    if (!ret)
+        Py_RETURN_FALSE;
+
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+VideoCap_frame_count(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    VideoCap_lock(self);
+    int64_t frame_count = self->vcap.get_frame_count();
+    VideoCap_unlock(self);
+
+    return PyLong_FromLongLong(frame_count);
+}
+
+
+static PyObject *
+VideoCap_keyframes(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    VideoCap_lock(self);
+    std::vector<int64_t> keyframes = self->vcap.get_keyframe_numbers();
+    VideoCap_unlock(self);
+
+    npy_intp dims[1] = {(npy_intp)keyframes.size()};
+    PyObject *keyframes_nd = PyArray_SimpleNew(1, dims, NPY_INT64);
+    if (keyframes_nd == NULL)
+        return NULL;
+
+    if (!keyframes.empty())
+        memcpy(PyArray_DATA((PyArrayObject *)keyframes_nd), keyframes.data(), keyframes.size() * sizeof(int64_t));
+
+    return keyframes_nd;
+}
+
+
+static PyObject *
+VideoCap_frame_number(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    VideoCap_lock(self);
+    int64_t frame_number = self->vcap.get_frame_number();
+    VideoCap_unlock(self);
+
+    return PyLong_FromLongLong(frame_number);
+}
+
+
+// Returns a new reference to `value` as int, or to None if it equals `unknown`
+static PyObject *
+int64_or_none(int64_t value, int64_t unknown)
+{
+    if (value == unknown)
+        Py_RETURN_NONE;
+    return PyLong_FromLongLong(value);
+}
+
+
+static PyObject *
+VideoCap_frame_metadata(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    FrameMetadata metadata;
+
+    VideoCap_lock(self);
+    bool valid = self->vcap.get_frame_metadata(&metadata);
+    VideoCap_unlock(self);
+
+    if (!valid)
+        Py_RETURN_NONE;
+
+    return Py_BuildValue("{s:N,s:N,s:N,s:(ii),s:N,s:N,s:d}",
+        "packet_size", int64_or_none(metadata.packet_size, -1),
+        "pts", int64_or_none(metadata.pts, AV_NOPTS_VALUE),
+        "dts", int64_or_none(metadata.dts, AV_NOPTS_VALUE),
+        "time_base", metadata.time_base.num, metadata.time_base.den,
+        "pos", int64_or_none(metadata.pos, -1),
+        "key_frame", PyBool_FromLong(metadata.key_frame),
+        "decode_time", metadata.decode_time);
+}
+
+
+static PyObject *
+VideoCap_stats(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
+{
+    VideoCap_lock(self);
+    VideoCapStats stats = self->vcap.get_stats();
+    VideoCap_unlock(self);
+
+    return Py_BuildValue("{s:L,s:d,s:d,s:d,s:d,s:d,s:N}",
+        "latency_count", (long long)stats.latency_count,
+        "latency_last", stats.latency_last,
+        "latency_mean", stats.latency_mean,
+        "latency_min", stats.latency_min,
+        "latency_max", stats.latency_max,
+        "open_time", stats.open_time,
+        "stream_info_cached", PyBool_FromLong(stats.stream_info_cached));
 }
 
 
 static PyObject *
 VideoCap_release(VideoCapObject *self, PyObject *Py_UNUSED(ignored))
 {
+    VideoCap_lock(self);
+    Py_BEGIN_ALLOW_THREADS
     self->vcap.release();
+    Py_END_ALLOW_THREADS
+    VideoCap_unlock(self);
     Py_RETURN_NONE;
 }
 
 
 static PyMethodDef VideoCap_methods[] = {
-    {"open", (PyCFunction) VideoCap_open, METH_VARARGS, "Open a video file or device with given filename/url"},
+    {"open", (PyCFunction)(void(*)(void)) VideoCap_open, METH_VARARGS | METH_KEYWORDS, "Open a video file or device with given filename/url"},
     {"read", (PyCFunction) VideoCap_read, METH_NOARGS, "Grab and decode the next frame and motion vectors"},
     {"grab", (PyCFunction) VideoCap_grab, METH_NOARGS, "Grab the next frame and motion vectors from the stream"},
     {"retrieve", (PyCFunction) VideoCap_retrieve, METH_NOARGS, "Decode the grabbed frame and motion vectors"},
+    {"read_yuv", (PyCFunction) VideoCap_read_yuv, METH_NOARGS, "Grab the next frame and return its decoded planes without conversion or copy"},
+    {"retrieve_yuv", (PyCFunction) VideoCap_retrieve_yuv, METH_NOARGS, "Return the decoded planes of the grabbed frame without conversion or copy"},
+    {"read_mvs", (PyCFunction) VideoCap_read_mvs, METH_NOARGS, "Grab the next frame and return only its motion vectors"},
+    {"retrieve_qp", (PyCFunction) VideoCap_retrieve_qp, METH_NOARGS, "Return the QP map of the grabbed frame with one value per macroblock"},
+    {"retrieve_mb_types", (PyCFunction) VideoCap_retrieve_mb_types, METH_NOARGS, "Return the macroblock types of the grabbed frame"},
+    {"read_into", (PyCFunction) VideoCap_read_into, METH_VARARGS, "Grab and decode the next frame and motion vectors into pre-allocated arrays"},
+    {"read_batch", (PyCFunction) VideoCap_read_batch, METH_VARARGS, "Grab and decode up to n frames and motion vectors at once"},
+    {"seek", (PyCFunction) VideoCap_seek, METH_VARARGS, "Seek to the frame with the given index"},
+    {"seek_time", (PyCFunction) VideoCap_seek_time, METH_VARARGS, "Seek to the given time in seconds"},
+    {"frame_count", (PyCFunction) VideoCap_frame_count, METH_NOARGS, "Return the number of frames of the video or -1 if unknown"},
+    {"keyframes", (PyCFunction) VideoCap_keyframes, METH_NOARGS, "Return the indices of all keyframes from the index sidecar"},
+    {"frame_number", (PyCFunction) VideoCap_frame_number, METH_NOARGS, "Return the index of the grabbed frame in the stream"},
+    {"frame_metadata", (PyCFunction) VideoCap_frame_metadata, METH_NOARGS, "Return metadata of the grabbed frame, such as the size of its packet"},
+    {"stats", (PyCFunction) VideoCap_stats, METH_NOARGS, "Return runtime statistics, such as the frame latency of live streams and the duration of open()"},
     {"release", (PyCFunction) VideoCap_release, METH_NOARGS, "Release the video device and free ressources"},
     {NULL}  /* Sentinel */
 };
@@ -189,7 +1289,7 @@ static PyTypeObject VideoCapType = {
     .tp_dictoffset = 0,
     .tp_init = NULL,
     .tp_alloc = NULL,
-    .tp_new = PyType_GenericNew,
+    .tp_new = VideoCap_new,
     .tp_free = NULL,
     .tp_is_gc = NULL,
     .tp_bases = NULL,
@@ -203,11 +1303,94 @@ static PyTypeObject VideoCapType = {
 };
 
 
+static PyObject *
+videocap_build_index(PyObject *Py_UNUSED(module), PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"url", "index_path", NULL};
+    const char *url;
+    const char *index_path = NULL;
+    bool ret;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|z", (char **)kwlist, &url, &index_path))
+        return NULL;
+
+    std::string path = index_path ? std::string(index_path) : VideoIndex::sidecar_path(url);
+
+    Py_BEGIN_ALLOW_THREADS
+    VideoIndex index;
+    ret = index.build(url) && index.save(path);
+    Py_END_ALLOW_THREADS
+
+    if (!ret)
+        Py_RETURN_FALSE;
+
+    Py_RETURN_TRUE;
+}
+
+
+static PyObject *
+videocap_mvs_pool_stats(PyObject *Py_UNUSED(module), PyObject *Py_UNUSED(ignored))
+{
+    BufferPoolStats stats = motion_vector_pool().get_stats();
+
+    return Py_BuildValue("{s:K,s:K,s:K,s:K}",
+        "hits", (unsigned long long)stats.hits,
+        "misses", (unsigned long long)stats.misses,
+        "cached_buffers", (unsigned long long)stats.cached_buffers,
+        "cached_bytes", (unsigned long long)stats.cached_bytes);
+}
+
+
+static PyObject *
+videocap_mvs_pool_clear(PyObject *Py_UNUSED(module), PyObject *Py_UNUSED(ignored))
+{
+    Py_BEGIN_ALLOW_THREADS
+    motion_vector_pool().clear();
+    Py_END_ALLOW_THREADS
+
+    Py_RETURN_NONE;
+}
+
+
+static PyObject *
+videocap_empty_motion_vectors(PyObject *Py_UNUSED(module), PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"mvs_layout", "mvs_dtype", NULL};
+    const char *mvs_layout = "aos";
+    const char *mvs_dtype = "int32";
+    VideoCapOptions options;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|ss", (char **)kwlist, &mvs_layout, &mvs_dtype))
+        return NULL;
+
+    if (!parse_mvs_layout(mvs_layout, &(options.mvs_layout)) ||
+        !parse_mvs_dtype(mvs_dtype, &(options.mvs_dtype)))
+        return NULL;
+
+    if (options.mvs_dtype == MVS_DTYPE_PACKED && options.mvs_layout == MVS_LAYOUT_SOA) {
+        PyErr_SetString(PyExc_ValueError, "mvs_dtype 'packed' can not be combined with mvs_layout 'soa'");
+        return NULL;
+    }
+
+    return mvs_array_from_data(options, 0, NULL);
+}
+
+
+static PyMethodDef videocap_methods[] = {
+    {"build_index", (PyCFunction)(void(*)(void)) videocap_build_index, METH_VARARGS | METH_KEYWORDS, "Build the index sidecar of a video file for fast seeking"},
+    {"mvs_pool_stats", (PyCFunction) videocap_mvs_pool_stats, METH_NOARGS, "Return the counters of the pool of motion vector buffers"},
+    {"mvs_pool_clear", (PyCFunction) videocap_mvs_pool_clear, METH_NOARGS, "Free all unused buffers of the pool of motion vector buffers"},
+    {"empty_motion_vectors", (PyCFunction)(void(*)(void)) videocap_empty_motion_vectors, METH_VARARGS | METH_KEYWORDS, "Return an empty motion vector array of the given layout and dtype"},
+    {NULL}  /* Sentinel */
+};
+
+
 static PyModuleDef videocapmodule = {
     PyModuleDef_HEAD_INIT,
     .m_name = "videocap",
     .m_doc = "Capture video frames and motion vectors from a H264 encoded stream.",
     .m_size = -1,
+    .m_methods = videocap_methods,
 };
 
 
@@ -227,5 +1410,17 @@ PyInit_videocap(void)
 
     Py_INCREF(&VideoCapType);
     PyModule_AddObject(m, "VideoCap", (PyObject *) &VideoCapType);
+
+    // values of the arrays returned by retrieve_mb_types()
+    PyModule_AddIntConstant(m, "MB_TYPE_INTRA_16X16", MB_TYPE_INTRA_16X16);
+    PyModule_AddIntConstant(m, "MB_TYPE_INTRA_NXN", MB_TYPE_INTRA_NXN);
+    PyModule_AddIntConstant(m, "MB_TYPE_INTRA_PCM", MB_TYPE_INTRA_PCM);
+    PyModule_AddIntConstant(m, "MB_TYPE_SKIP", MB_TYPE_SKIP);
+    PyModule_AddIntConstant(m, "MB_TYPE_DIRECT", MB_TYPE_DIRECT);
+    PyModule_AddIntConstant(m, "MB_TYPE_INTER_16X16", MB_TYPE_INTER_16X16);
+    PyModule_AddIntConstant(m, "MB_TYPE_INTER_16X8", MB_TYPE_INTER_16X8);
+    PyModule_AddIntConstant(m, "MB_TYPE_INTER_8X16", MB_TYPE_INTER_8X16);
+    PyModule_AddIntConstant(m, "MB_TYPE_INTER_8X8", MB_TYPE_INTER_8X8);
+    PyModule_AddIntConstant(m, "MB_TYPE_UNKNOWN", MB_TYPE_UNKNOWN);
     return m;
 }
@@ -0,0 +1,179 @@
+#include "sliced_scaler.hpp"
+
+#include <algorithm>
+
+
+// slices with fewer rows are not worth the synchronization
+static const int min_slice_height = 16;
+
+
+SlicedScaler::SlicedScaler() {
+    this->src_linesize = NULL;
+    this->dst_linesize = NULL;
+    this->generation = 0;
+    this->pending = 0;
+    this->stopping = false;
+}
+
+
+SlicedScaler::~SlicedScaler() {
+    this->release();
+}
+
+
+void SlicedScaler::release(void) {
+    this->stop_workers();
+
+    for (Slice &slice : this->slices)
+        sws_freeContext(slice.ctx);
+    this->slices.clear();
+}
+
+
+bool SlicedScaler::scale(const AVFrame *src, uint8_t *const dst_data[4], const int dst_linesize[4],
+    int dst_width, AVPixelFormat dst_format, int flags, int threads) {
+
+    const AVPixFmtDescriptor *src_desc = av_pix_fmt_desc_get((AVPixelFormat)src->format);
+    const AVPixFmtDescriptor *dst_desc = av_pix_fmt_desc_get(dst_format);
+    if (!src_desc || !dst_desc)
+        return false;
+
+    // slice borders must not split a chroma row, the unscaled converters of
+    // libswscale also process pairs of rows
+    int src_chroma_shift = src_desc->log2_chroma_h;
+    int dst_chroma_shift = dst_desc->log2_chroma_h;
+    int align = std::max(2, 1 << std::max(src_chroma_shift, dst_chroma_shift));
+
+    int num_slices = std::min(threads, src->height / std::max(min_slice_height, align));
+    // the second plane of paletted formats is the palette, which can not be sliced
+    if ((src_desc->flags & AV_PIX_FMT_FLAG_PAL) || (dst_desc->flags & AV_PIX_FMT_FLAG_PAL))
+        num_slices = 1;
+    num_slices = std::max(1, num_slices);
+
+    if ((int)this->slices.size() != num_slices) {
+        this->release();
+        this->slices.resize(num_slices);
+        for (Slice &slice : this->slices)
+            slice.ctx = NULL;
+    }
+
+    int aligned_rows = src->height / align;
+    for (int i = 0; i < num_slices; i++) {
+        Slice &slice = this->slices[i];
+        int y = (aligned_rows * i / num_slices) * align;
+        int y_next = (i == num_slices - 1) ? src->height : (aligned_rows * (i + 1) / num_slices) * align;
+        slice.height = y_next - y;
+        slice.result = 0;
+
+        // returns the previous context if none of the parameters changed
+        slice.ctx = sws_getCachedContext(
+            slice.ctx,
+            src->width, slice.height,
+            (AVPixelFormat)src->format,
+            dst_width, slice.height,
+            dst_format,
+            flags,
+            NULL, NULL, NULL
+            );
+
+        if (slice.ctx == NULL)
+            return false;
+
+        // planes 1 and 2 are the chroma planes of YUV formats, the second plane of NV12 is chroma as well
+        for (int p = 0; p < 4; p++) {
+            int src_y = (p == 1 || p == 2) ? (y >> src_chroma_shift) : y;
+            int dst_y = (p == 1 || p == 2) ? (y >> dst_chroma_shift) : y;
+            slice.src_data[p] = src->data[p] ? src->data[p] + (ptrdiff_t)src_y * src->linesize[p] : NULL;
+            slice.dst_data[p] = dst_data[p] ? dst_data[p] + (ptrdiff_t)dst_y * dst_linesize[p] : NULL;
+        }
+    }
+
+    this->src_linesize = src->linesize;
+    this->dst_linesize = dst_linesize;
+
+    if (this->workers.size() != (size_t)(num_slices - 1))
+        this->start_workers(num_slices - 1);
+
+    if (!this->workers.empty()) {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->generation++;
+        this->pending = (int)this->workers.size();
+        this->start_cond.notify_all();
+    }
+
+    // the first slice is converted on the calling thread
+    this->run_slice(0);
+
+    if (!this->workers.empty()) {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        this->done_cond.wait(lock, [this] { return this->pending == 0; });
+    }
+
+    bool valid = true;
+    for (const Slice &slice : this->slices) {
+        if (slice.result != slice.height)
+            valid = false;
+    }
+
+    return valid;
+}
+
+
+void SlicedScaler::run_slice(size_t i) {
+    Slice &slice = this->slices[i];
+    slice.result = sws_scale(
+        slice.ctx,
+        slice.src_data,
+        this->src_linesize,
+        0, slice.height,
+        slice.dst_data,
+        this->dst_linesize
+        );
+}
+
+
+void SlicedScaler::worker_loop(size_t i, uint64_t generation) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->start_cond.wait(lock, [this, generation] {
+                return this->stopping || this->generation != generation; });
+            if (this->stopping)
+                return;
+            generation = this->generation;
+        }
+
+        this->run_slice(i);
+
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            if (--this->pending == 0)
+                this->done_cond.notify_one();
+        }
+    }
+}
+
+
+void SlicedScaler::start_workers(size_t count) {
+    this->stop_workers();
+
+    // worker i converts slice i + 1 of every frame after the current generation
+    for (size_t i = 0; i < count; i++)
+        this->workers.emplace_back(&SlicedScaler::worker_loop, this, i + 1, this->generation);
+}
+
+
+void SlicedScaler::stop_workers(void) {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->start_cond.notify_all();
+    }
+
+    for (std::thread &worker : this->workers)
+        worker.join();
+    this->workers.clear();
+
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->stopping = false;
+}
@@ -0,0 +1,98 @@
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+extern "C" {
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+
+/**
+* Converts frames with libswscale on several threads.
+*
+* The frame is split into horizontal slices, each of which is converted by
+* its own `SwsContext` as if it were an independent image. One slice is
+* converted on the calling thread, the others on a pool of worker threads
+* which is kept alive between frames.
+*
+* Slicing requires that the frame is not scaled vertically. Slice borders are
+* aligned to the vertical chroma subsampling of source and destination
+* format. The result is identical to an unsliced conversion if libswscale
+* uses one of its unscaled converters (e.g. YUV420P to BGR24 or RGB24 in the
+* same size). Otherwise, the chroma interpolation of the rows next to a slice
+* border may differ slightly, because it does not see the rows of the
+* neighbouring slice.
+*/
+class SlicedScaler
+{
+public:
+    SlicedScaler();
+    ~SlicedScaler();
+
+    SlicedScaler(const SlicedScaler &) = delete;
+    SlicedScaler &operator=(const SlicedScaler &) = delete;
+
+    /** Converts a frame into the destination planes
+    *
+    * @param src Frame to convert.
+    *
+    * @param dst_data Destination planes. The destination has the same height
+    *   as the source frame.
+    *
+    * @param dst_linesize Size of a row of each destination plane in bytes.
+    *
+    * @param dst_width Width of the destination in pixels.
+    *
+    * @param dst_format Pixel format of the destination.
+    *
+    * @param flags Scaling algorithm of libswscale, e.g. `SWS_BICUBIC`.
+    *
+    * @param threads Number of slices which are converted in parallel. Small
+    *   frames are split into fewer slices.
+    *
+    * @retval true on success, false if a context could not be created or a
+    *   slice could not be converted.
+    */
+    bool scale(const AVFrame *src, uint8_t *const dst_data[4], const int dst_linesize[4],
+        int dst_width, AVPixelFormat dst_format, int flags, int threads);
+
+    /** Stops the worker threads and frees all contexts */
+    void release(void);
+
+private:
+    struct Slice
+    {
+        struct SwsContext *ctx;
+        int height;
+        const uint8_t *src_data[4];
+        uint8_t *dst_data[4];
+        int result;
+    };
+
+    /** Slices of the current frame, workers only read them while a frame is converted */
+    std::vector<Slice> slices;
+    const int *src_linesize;
+    const int *dst_linesize;
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable start_cond;
+    std::condition_variable done_cond;
+    uint64_t generation;
+    int pending;
+    bool stopping;
+
+    /** Converts a single slice */
+    void run_slice(size_t i);
+
+    /** Waits for frames newer than `generation` and converts the slice with
+    *   index `i` of each of them */
+    void worker_loop(size_t i, uint64_t generation);
+
+    void start_workers(size_t count);
+    void stop_workers(void);
+};
@@ -0,0 +1,216 @@
+#include "stream_info_cache.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+// FNV-1a hash, only used for fingerprints and file names, not for security
+static uint64_t fnv1a(const void *data, size_t size, uint64_t hash = 14695981039346656037ULL) {
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+static uint64_t fnv1a_int(int64_t value, uint64_t hash) {
+    return fnv1a(&value, sizeof(value), hash);
+}
+
+
+uint64_t stream_info_fingerprint(AVFormatContext *fmt_ctx) {
+    uint64_t hash = fnv1a(fmt_ctx->iformat->name, strlen(fmt_ctx->iformat->name));
+    hash = fnv1a_int(fmt_ctx->nb_streams, hash);
+
+    for (unsigned int i = 0; i < fmt_ctx->nb_streams; i++) {
+        AVStream *st = fmt_ctx->streams[i];
+        hash = fnv1a_int(st->codecpar->codec_type, hash);
+        hash = fnv1a_int(st->codecpar->codec_id, hash);
+        hash = fnv1a_int(st->time_base.num, hash);
+        hash = fnv1a_int(st->time_base.den, hash);
+        hash = fnv1a_int(st->codecpar->extradata_size, hash);
+        if (st->codecpar->extradata_size > 0)
+            hash = fnv1a(st->codecpar->extradata, st->codecpar->extradata_size, hash);
+    }
+
+    return hash;
+}
+
+
+std::string stream_info_cache_path(const std::string &cache_dir, const std::string &url) {
+    std::ostringstream path;
+    path << cache_dir;
+    if (!cache_dir.empty() && cache_dir.back() != '/')
+        path << '/';
+    path << std::hex << std::setw(16) << std::setfill('0') << fnv1a(url.data(), url.size()) << ".streaminfo";
+    return path.str();
+}
+
+
+bool load_stream_info(const std::string &path, StreamInfo *info) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    StreamInfo loaded;
+    std::string key;
+    bool has_fingerprint = false;
+
+    while (file >> key) {
+        if (key == "fingerprint") {
+            file >> std::hex >> loaded.fingerprint >> std::dec;
+            has_fingerprint = true;
+        }
+        else if (key == "stream_index")
+            file >> loaded.stream_index;
+        else if (key == "codec_id")
+            file >> loaded.codec_id;
+        else if (key == "width")
+            file >> loaded.width;
+        else if (key == "height")
+            file >> loaded.height;
+        else if (key == "format")
+            file >> loaded.format;
+        else if (key == "profile")
+            file >> loaded.profile;
+        else if (key == "level")
+            file >> loaded.level;
+        else if (key == "sample_aspect_ratio")
+            file >> loaded.sample_aspect_ratio.num >> loaded.sample_aspect_ratio.den;
+        else if (key == "avg_frame_rate")
+            file >> loaded.avg_frame_rate.num >> loaded.avg_frame_rate.den;
+        else if (key == "r_frame_rate")
+            file >> loaded.r_frame_rate.num >> loaded.r_frame_rate.den;
+        else if (key == "extradata") {
+            std::string hex;
+            file >> hex;
+            if (hex == "-")
+                continue;
+            if (hex.size() % 2 != 0)
+                return false;
+            loaded.extradata.resize(hex.size() / 2);
+            for (size_t i = 0; i < loaded.extradata.size(); i++)
+                loaded.extradata[i] = (uint8_t)strtoul(hex.substr(2 * i, 2).c_str(), NULL, 16);
+        }
+        // ignore unknown keys, they may come from newer versions
+
+        if (file.fail())
+            return false;
+    }
+
+    if (!has_fingerprint || loaded.stream_index < 0 || loaded.codec_id == AV_CODEC_ID_NONE)
+        return false;
+
+    *info = loaded;
+    return true;
+}
+
+
+bool save_stream_info(const std::string &path, const StreamInfo &info) {
+    size_t dir_end = path.rfind('/');
+    if (dir_end != std::string::npos && dir_end > 0)
+        mkdir(path.substr(0, dir_end).c_str(), 0755);
+
+    // write into a temporary file first and rename it, which is atomic
+    std::ostringstream tmp_path;
+    tmp_path << path << ".tmp" << getpid();
+
+    {
+        std::ofstream file(tmp_path.str(), std::ios::trunc);
+        if (!file)
+            return false;
+
+        file << "fingerprint " << std::hex << std::setw(16) << std::setfill('0') << info.fingerprint << std::dec << "\n";
+        file << "stream_index " << info.stream_index << "\n";
+        file << "codec_id " << info.codec_id << "\n";
+        file << "width " << info.width << "\n";
+        file << "height " << info.height << "\n";
+        file << "format " << info.format << "\n";
+        file << "profile " << info.profile << "\n";
+        file << "level " << info.level << "\n";
+        file << "sample_aspect_ratio " << info.sample_aspect_ratio.num << " " << info.sample_aspect_ratio.den << "\n";
+        file << "avg_frame_rate " << info.avg_frame_rate.num << " " << info.avg_frame_rate.den << "\n";
+        file << "r_frame_rate " << info.r_frame_rate.num << " " << info.r_frame_rate.den << "\n";
+        file << "extradata ";
+        if (info.extradata.empty())
+            file << "-";
+        file << std::hex << std::setfill('0');
+        for (uint8_t byte : info.extradata)
+            file << std::setw(2) << (int)byte;
+        file << std::dec << "\n";
+
+        file.close();
+        if (file.fail()) {
+            std::remove(tmp_path.str().c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.str().c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+void get_stream_info(AVStream *st, int stream_index, uint64_t fingerprint, StreamInfo *info) {
+    AVCodecParameters *par = st->codecpar;
+
+    info->fingerprint = fingerprint;
+    info->stream_index = stream_index;
+    info->codec_id = par->codec_id;
+    info->width = par->width;
+    info->height = par->height;
+    info->format = par->format;
+    info->profile = par->profile;
+    info->level = par->level;
+    info->sample_aspect_ratio = par->sample_aspect_ratio;
+    info->avg_frame_rate = st->avg_frame_rate;
+    info->r_frame_rate = st->r_frame_rate;
+    info->extradata.assign(par->extradata, par->extradata + par->extradata_size);
+}
+
+
+bool apply_stream_info(AVStream *st, const StreamInfo &info) {
+    AVCodecParameters *par = st->codecpar;
+
+    par->codec_type = AVMEDIA_TYPE_VIDEO;
+    if (par->codec_id == AV_CODEC_ID_NONE)
+        par->codec_id = (enum AVCodecID)info.codec_id;
+    if (par->width <= 0 || par->height <= 0) {
+        par->width = info.width;
+        par->height = info.height;
+    }
+    if (par->format < 0)
+        par->format = info.format;
+    if (par->profile == FF_PROFILE_UNKNOWN)
+        par->profile = info.profile;
+    if (par->level == FF_LEVEL_UNKNOWN)
+        par->level = info.level;
+    if (par->sample_aspect_ratio.num == 0)
+        par->sample_aspect_ratio = info.sample_aspect_ratio;
+    if (st->avg_frame_rate.num == 0)
+        st->avg_frame_rate = info.avg_frame_rate;
+    if (st->r_frame_rate.num == 0)
+        st->r_frame_rate = info.r_frame_rate;
+
+    // the decoder needs the parameter sets before the first keyframe if they are not sent in-band
+    if (par->extradata_size == 0 && !info.extradata.empty()) {
+        par->extradata = (uint8_t *)av_mallocz(info.extradata.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+        if (!par->extradata)
+            return false;
+        memcpy(par->extradata, info.extradata.data(), info.extradata.size());
+        par->extradata_size = (int)info.extradata.size();
+    }
+
+    return true;
+}
@@ -0,0 +1,89 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+
+/**
+* Codec parameters of a video stream which are normally found by
+* `avformat_find_stream_info`.
+*
+* They are stored in an on-disk cache after a stream has been probed once, so
+* that later opens of the same url can skip probing, which reads several
+* seconds of packets for RTSP streams.
+*/
+struct StreamInfo
+{
+    /** Fingerprint of the stream as returned by `stream_info_fingerprint` */
+    uint64_t fingerprint = 0;
+
+    /** Index of the video stream in the format context */
+    int stream_index = -1;
+
+    int codec_id = AV_CODEC_ID_NONE;
+    int width = 0;
+    int height = 0;
+    int format = -1;
+    int profile = FF_PROFILE_UNKNOWN;
+    int level = FF_LEVEL_UNKNOWN;
+    AVRational sample_aspect_ratio = {0, 1};
+    AVRational avg_frame_rate = {0, 1};
+    AVRational r_frame_rate = {0, 1};
+
+    /** Codec extradata, e.g. the SPS and PPS of H.264 streams */
+    std::vector<uint8_t> extradata;
+};
+
+
+/**
+* Computes a fingerprint of an opened but not yet probed input.
+*
+* The fingerprint covers everything the demuxer knows right after
+* `avformat_open_input`, i.e. the container format and the type, codec,
+* time base and extradata (e.g. from the SDP of RTSP streams) of each stream.
+* If any of these change, e.g. because the camera was reconfigured, the
+* fingerprint changes and cached stream info must not be used anymore.
+*/
+uint64_t stream_info_fingerprint(AVFormatContext *fmt_ctx);
+
+
+/**
+* Returns the path of the cache file for the given url in the cache directory.
+*/
+std::string stream_info_cache_path(const std::string &cache_dir, const std::string &url);
+
+
+/**
+* Loads stream info from a cache file.
+*
+* @retval true if the file exists and is valid, false otherwise.
+*/
+bool load_stream_info(const std::string &path, StreamInfo *info);
+
+
+/**
+* Stores stream info in a cache file. The cache directory is created if it
+* does not exist. The file is replaced atomically, so that concurrent readers
+* never see a partially written file.
+*
+* @retval true if the file was written, false otherwise.
+*/
+bool save_stream_info(const std::string &path, const StreamInfo &info);
+
+
+/**
+* Copies the codec parameters of a probed stream into a `StreamInfo`.
+*/
+void get_stream_info(AVStream *st, int stream_index, uint64_t fingerprint, StreamInfo *info);
+
+
+/**
+* Fills the codec parameters of an unprobed stream from a `StreamInfo`.
+* Parameters which the demuxer already knows are not overwritten.
+*
+* @retval true on success, false if memory could not be allocated.
+*/
+bool apply_stream_info(AVStream *st, const StreamInfo &info);
@@ -10,12 +10,23 @@ VideoCap::VideoCap() {
     this->video_stream_idx = -1;
     this->frame = NULL;
     this->img_convert_ctx = NULL;
-    this->frame_number = 0;
+    this->frame_number = -1;
+    this->first_frame_pts = AV_NOPTS_VALUE;
     this->frame_timestamp = 0.0;
+    this->frame_timestamp_synced = false;
+    this->creation_time = AV_NOPTS_VALUE;
+    this->decode_time = 0.0;
+    this->frame_decode_time = 0.0;
+    this->stats = VideoCapStats();
     this->is_rtsp = false;
-
-    memset(&(this->rgb_frame), 0, sizeof(this->rgb_frame));
-    memset(&(this->picture), 0, sizeof(this->picture));
+    this->frame_held = false;
+    this->stream_info_path.clear();
+    this->stream_info = StreamInfo();
+    this->stream_info_verified = false;
+    this->index.clear();
+
+    this->frame_buffer = NULL;
+    this->frame_buffer_size = 0;
     memset(&(this->packet), 0, sizeof(this->packet));
     av_init_packet(&(this->packet));
 }
@@ -27,14 +38,18 @@ void VideoCap::release(void) {
         this->img_convert_ctx = NULL;
     }
 
+    this->sliced_scaler.release();
+
     if (this->frame != NULL) {
         av_frame_free(&(this->frame));
         this->frame = NULL;
     }
 
-    av_frame_unref(&(this->rgb_frame));
-    memset(&(this->rgb_frame), 0, sizeof(this->rgb_frame));
-    memset(&(this->picture), 0, sizeof(this->picture));
+    if (this->frame_buffer != NULL) {
+        av_freep(&(this->frame_buffer));
+        this->frame_buffer = NULL;
+    }
+    this->frame_buffer_size = 0;
 
     if (this->video_dec_ctx != NULL) {
         avcodec_free_context(&(this->video_dec_ctx));
@@ -61,17 +76,33 @@ void VideoCap::release(void) {
     this->codec = NULL;
     this->video_stream = NULL;
     this->video_stream_idx = -1;
-    this->frame_number = 0;
+    this->options = VideoCapOptions();
+    this->frame_number = -1;
+    this->first_frame_pts = AV_NOPTS_VALUE;
     this->frame_timestamp = 0.0;
+    this->frame_timestamp_synced = false;
+    this->creation_time = AV_NOPTS_VALUE;
+    this->decode_time = 0.0;
+    this->frame_decode_time = 0.0;
+    this->stats = VideoCapStats();
     this->is_rtsp = false;
+    this->frame_held = false;
+    this->stream_info_path.clear();
+    this->stream_info = StreamInfo();
+    this->stream_info_verified = false;
+    this->index.clear();
+    this->rtcp_timestamps.clear();
 }
 
 
-bool VideoCap::open(const char *url) {
+bool VideoCap::open(const char *url, const VideoCapOptions &options) {
 
     bool valid = false;
     AVStream *st = NULL;
     int enc_width, enc_height, idx;
+    uint64_t fingerprint = 0;
+    bool stream_info_cached = false;
+    auto open_start = std::chrono::steady_clock::now();
 
     this->release();
 
@@ -80,29 +111,88 @@ bool VideoCap::open(const char *url) {
         goto error;
 
     this->url = url;
+    this->options = options;
+
+    // only packed formats with a single plane and planar 4:2:0 formats fit into a single array
+    switch (this->options.output_format) {
+        case AV_PIX_FMT_BGR24:
+        case AV_PIX_FMT_RGB24:
+        case AV_PIX_FMT_GRAY8:
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_YUV420P:
+            break;
+        default:
+            goto error;
+    }
+
+    if (this->options.output_width < 0 || this->options.output_height < 0 || this->options.scale_threads < 0)
+        goto error;
+
+    // packed motion vectors are structures, they can not be stored as structure of arrays
+    if (this->options.mvs_dtype == MVS_DTYPE_PACKED && this->options.mvs_layout == MVS_LAYOUT_SOA)
+        goto error;
 
     // open RTSP stream with TCP
     av_dict_set(&(this->opts), "rtsp_transport", "tcp", 0);
     av_dict_set(&(this->opts), "stimeout", "5000000", 0); // set timeout to 5 seconds
+
+    // do not buffer or reorder packets and find stream parameters from as little data as possible
+    if (this->options.low_latency) {
+        av_dict_set(&(this->opts), "fflags", "nobuffer", 0);
+        av_dict_set(&(this->opts), "probesize", "32768", 0);
+        av_dict_set(&(this->opts), "analyzeduration", "500000", 0);
+        av_dict_set(&(this->opts), "max_delay", "0", 0);
+    }
+
     if (avformat_open_input(&(this->fmt_ctx), url, NULL, &(this->opts)) < 0)
         goto error;
 
     // determine if opened stream is RTSP or not (e.g. a video file)
     this->is_rtsp = check_format_rtsp(this->fmt_ctx->iformat->name);
 
-    // read packets of a media file to get stream information.
-    if (avformat_find_stream_info(this->fmt_ctx, NULL) < 0)
-        goto error;
+    // use the stream info of a previous open of the same stream if it did not change
+    if (!this->options.stream_info_cache.empty()) {
+        this->stream_info_path = stream_info_cache_path(this->options.stream_info_cache, url);
+        fingerprint = stream_info_fingerprint(this->fmt_ctx);
+        stream_info_cached = load_stream_info(this->stream_info_path, &(this->stream_info)) &&
+            this->stream_info.fingerprint == fingerprint &&
+            this->stream_info.stream_index < (int)this->fmt_ctx->nb_streams;
+    }
 
-    // find the most suitable stream of given type (e.g. video) and set the codec accordingly
-    idx = av_find_best_stream(this->fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &(this->codec), 0);
-    if (idx < 0)
-        goto error;
+    if (stream_info_cached) {
+        idx = this->stream_info.stream_index;
+        if (!apply_stream_info(this->fmt_ctx->streams[idx], this->stream_info))
+            goto error;
+
+        this->codec = avcodec_find_decoder(this->fmt_ctx->streams[idx]->codecpar->codec_id);
+        if (!this->codec)
+            goto error;
+    }
+    else {
+        // read packets of a media file to get stream information.
+        if (avformat_find_stream_info(this->fmt_ctx, NULL) < 0)
+            goto error;
+
+        // find the most suitable stream of given type (e.g. video) and set the codec accordingly
+        idx = av_find_best_stream(this->fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &(this->codec), 0);
+        if (idx < 0)
+            goto error;
+    }
 
     // set stream in format context
     this->video_stream_idx = idx;
     st = this->fmt_ctx->streams[this->video_stream_idx];
 
+    // load the index sidecar of video files, it is ignored if it belongs to another file or stream
+    if (!this->is_rtsp) {
+        std::string index_path = this->options.index_path;
+        if (index_path.empty())
+            index_path = VideoIndex::sidecar_path(url);
+        if (this->index.load(index_path, url) && (this->index.stream_index != idx ||
+            av_cmp_q(this->index.time_base, st->time_base) != 0))
+            this->index.clear();
+    }
+
     // allocate an AVCodecContext and set its fields to default values
     this->video_dec_ctx = avcodec_alloc_context3(this->codec);
     if (!this->video_dec_ctx)
@@ -113,11 +203,35 @@ bool VideoCap::open(const char *url) {
         goto error;
 
     // ffmpeg recommends no more than 16 threads
-    this->video_dec_ctx->thread_count = std::min(std::thread::hardware_concurrency(), 16u);
+    if (this->options.thread_count > 0)
+        this->video_dec_ctx->thread_count = this->options.thread_count;
+    else
+        this->video_dec_ctx->thread_count = std::min(std::thread::hardware_concurrency(), 16u);
+    this->video_dec_ctx->thread_type = this->options.thread_type;
+
+    // output frames as soon as they are decoded, frame threading would delay them
+    if (this->options.low_latency) {
+        this->video_dec_ctx->flags |= AV_CODEC_FLAG_LOW_DELAY;
+        this->video_dec_ctx->thread_type = FF_THREAD_SLICE;
+    }
 #ifdef DEBUG
     std::cerr << "Using parallel processing with " << this->video_dec_ctx->thread_count << " threads" << std::endl;
 #endif
 
+    // let the decoder skip frames no other frame depends on
+    if (this->options.skip_nonref)
+        this->video_dec_ctx->skip_frame = AVDISCARD_NONREF;
+
+    // let the decoder discard any non-keyframe which still reaches it, this includes non-reference frames
+    if (this->options.keyframes_only)
+        this->video_dec_ctx->skip_frame = AVDISCARD_NONKEY;
+
+    // skip reconstruction steps which come after motion vector parsing
+    if (this->options.decode_profile == DECODE_PROFILE_MVS) {
+        this->video_dec_ctx->skip_loop_filter = AVDISCARD_ALL;
+        this->video_dec_ctx->skip_idct = AVDISCARD_ALL;
+    }
+
     // backup encoder's width/height
     enc_width = this->video_dec_ctx->width;
     enc_height = this->video_dec_ctx->height;
@@ -135,10 +249,6 @@ bool VideoCap::open(const char *url) {
     if (enc_height && (this->video_dec_ctx->height != enc_height))
         this->video_dec_ctx->height = enc_height;
 
-    this->picture.width = this->video_dec_ctx->width;
-    this->picture.height = this->video_dec_ctx->height;
-    this->picture.data = NULL;
-
     // print info (duration, bitrate, streams, container, programs, metadata, side data, codec, time base)
 #ifdef DEBUG
     av_dump_format(this->fmt_ctx, 0, url, 0);
@@ -148,9 +258,26 @@ bool VideoCap::open(const char *url) {
     if (!this->frame)
         goto error;
 
+    // the creation time is stored in ISO 8601 format, e.g. "2020-01-01T12:00:00.000000Z"
+    if (this->options.timestamp_source == TIMESTAMP_SOURCE_CREATION_TIME) {
+        AVDictionaryEntry *tag = av_dict_get(this->fmt_ctx->metadata, "creation_time", NULL, 0);
+        int64_t creation_time;
+        if (tag && av_parse_time(&creation_time, tag->value, 0) == 0)
+            this->creation_time = creation_time;
+    }
+
     if (this->video_stream_idx >= 0)
         valid = true;
 
+    // store the probed stream info for the next open, failing to do so is not an error
+    if (valid && !this->stream_info_path.empty() && !stream_info_cached) {
+        get_stream_info(st, idx, fingerprint, &(this->stream_info));
+        save_stream_info(this->stream_info_path, this->stream_info);
+    }
+
+    this->stats.stream_info_cached = stream_info_cached;
+    this->stats.open_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - open_start).count();
+
 error:
 
     if (!valid)
@@ -160,181 +287,469 @@ error:
 }
 
 
+const VideoCapOptions &VideoCap::get_options(void) {
+    return this->options;
+}
+
+
+VideoCapStats VideoCap::get_stats(void) {
+    return this->stats;
+}
+
+
+void VideoCap::update_latency_stats(void) {
+
+    // the capture time is only known from RTCP sender reports
+    if (!this->frame_timestamp_synced)
+        return;
+
+    auto now = std::chrono::system_clock::now();
+    double latency = std::chrono::duration<double>(now.time_since_epoch()).count() - this->frame_timestamp;
+
+    VideoCapStats *stats = &(this->stats);
+    stats->latency_count++;
+    stats->latency_last = latency;
+    stats->latency_mean += (latency - stats->latency_mean) / stats->latency_count;
+    if (stats->latency_count == 1 || latency < stats->latency_min)
+        stats->latency_min = latency;
+    if (stats->latency_count == 1 || latency > stats->latency_max)
+        stats->latency_max = latency;
+}
+
+
+void VideoCap::verify_stream_info(void) {
+
+    if (this->stream_info_verified || !this->stats.stream_info_cached)
+        return;
+    this->stream_info_verified = true;
+
+    // the stream changed in a way the fingerprint does not cover, probe it again on the next open
+    if (this->frame->width != this->stream_info.width || this->frame->height != this->stream_info.height)
+        std::remove(this->stream_info_path.c_str());
+}
+
+
 bool VideoCap::grab(void) {
 
     bool valid = false;
-    int got_frame;
+    int ret;
 
     int count_errs = 0;
     const int max_number_of_attempts = 512;
+    const size_t max_number_of_timestamps = 512;
 
     // make sure file is opened
     if (!this->fmt_ctx || !this->video_stream)
         return false;
 
-    // check if there is a frame left in the stream
-    if (this->fmt_ctx->streams[this->video_stream_idx]->nb_frames > 0 &&
-        this->frame_number > this->fmt_ctx->streams[this->video_stream_idx]->nb_frames)
-        return false;
+    // return the frame kept by hold_frame() without reading a new one
+    if (this->frame_held) {
+        this->frame_held = false;
+        return true;
+    }
 
-    // loop over different streams (video, audio) in the file
     while(!valid) {
-        av_packet_unref(&(this->packet));
 
-        // read next packet from the stream
-        int ret = av_read_frame(this->fmt_ctx, &(this->packet));
+        // output the next frame if the decoder has one ready
+        auto decode_start = std::chrono::steady_clock::now();
+        ret = avcodec_receive_frame(this->video_dec_ctx, this->frame);
+        this->decode_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - decode_start).count();
+
+        if (ret == 0) {
+            this->frame_decode_time = this->decode_time;
+            this->decode_time = 0.0;
+            this->verify_stream_info();
+            this->frame_timestamp = this->get_frame_timestamp();
+#ifdef DEBUG
+            std::cerr << "frame_timestamp (UNIX): " << std::fixed << this->frame_timestamp << std::endl;
+#endif
+            this->frame_number = this->compute_frame_number();
+            valid = true;
+            break;
+        }
+
+        // all frames have been drained from the decoder at the end of the stream
+        if (ret == AVERROR_EOF)
+            break;
+
+        // a decoding error occurred, try with the next frame
+        if (ret != AVERROR(EAGAIN)) {
+            count_errs++;
+            if (count_errs > max_number_of_attempts)
+                break;
+            continue;
+        }
+
+        // the decoder needs more input, read next packet from the stream
+        av_packet_unref(&(this->packet));
+        ret = av_read_frame(this->fmt_ctx, &(this->packet));
 
         if (ret == AVERROR(EAGAIN))
             continue;
 
+        // at the end of the stream enter draining mode, in which the decoder
+        // outputs all frames it still buffers (e.g. due to frame threading)
+        if (ret == AVERROR_EOF) {
+            avcodec_send_packet(this->video_dec_ctx, NULL);
+            continue;
+        }
+
+        // other errors may be transient (e.g. network errors of live streams),
+        // retry without draining the decoder, which could not be undone
+        if (ret < 0) {
+            count_errs++;
+            if (count_errs > max_number_of_attempts)
+                break;
+            continue;
+        }
+
         // if the packet is not from the video stream don't do anything and get next packet
         if (this->packet.stream_index != this->video_stream_idx) {
-            av_packet_unref(&(this->packet));
             count_errs++;
             if (count_errs > max_number_of_attempts)
                 break;
             continue;
         }
 
-        // decode the video frame
-        avcodec_decode_video2(this->video_dec_ctx, this->frame, &got_frame, &(this->packet));
-
-        if(got_frame) {
-#ifdef DEBUG
-            // get timestamps of packet from RTPS stream
-            std::cerr << "### Frame No. " <<  this->frame_number << " ###" << std::endl;
-            std::cerr << "synced: " << packet.synced << std::endl;
-            std::cerr << "seq: " << packet.seq << std::endl;
-            std::cerr << "timestamp: " << packet.timestamp << std::endl;
-            std::cerr << "last_rtcp_ntp_time (NTP): " << packet.last_rtcp_ntp_time << std::endl;
-            struct timeval last_rtcp_ntp_time_unix;
-            ntp2tv(&packet.last_rtcp_ntp_time, &last_rtcp_ntp_time_unix);
-            std::cerr << "last_rtcp_ntp_time (UNIX): ";
-            printf("%ld.%06ld\n", last_rtcp_ntp_time_unix.tv_sec, last_rtcp_ntp_time_unix.tv_usec);
-            std::cerr << "last_rtcp_timestamp: " << packet.last_rtcp_timestamp << std::endl;
-#endif
+        // drop packets of non-keyframes before they are decoded, this is not an error
+        if (this->options.keyframes_only && !(this->packet.flags & AV_PKT_FLAG_KEY))
+            continue;
 
-            // wait for the first RTCP sender report containing RTP timestamp <-> NTP walltime mapping,
-            // before this no reliable frame timestmap can be computed
-            if (this->is_rtsp && packet.synced) {
-                // compute absolute UNIX timestamp for each frame as follows (90 kHz clock as in RTP spec):
-                // frame_time_unix = last_rtcp_ntp_time_unix + (timestamp - last_rtcp_timestamp) / 90000
-                struct timeval tv;
-                ntp2tv(&packet.last_rtcp_ntp_time, &tv);
-                double rtp_diff = (double)(packet.timestamp - packet.last_rtcp_timestamp) / 90000.0;
-                this->frame_timestamp = (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0 + rtp_diff;
 #ifdef DEBUG
-                std::cerr << "frame_timestamp (UNIX): " << std::fixed << this->frame_timestamp << std::endl;
+        // get timestamps of packet from RTPS stream
+        std::cerr << "### Packet ###" << std::endl;
+        std::cerr << "synced: " << packet.synced << std::endl;
+        std::cerr << "seq: " << packet.seq << std::endl;
+        std::cerr << "timestamp: " << packet.timestamp << std::endl;
+        std::cerr << "last_rtcp_ntp_time (NTP): " << packet.last_rtcp_ntp_time << std::endl;
+        struct timeval last_rtcp_ntp_time_unix;
+        ntp2tv(&packet.last_rtcp_ntp_time, &last_rtcp_ntp_time_unix);
+        std::cerr << "last_rtcp_ntp_time (UNIX): ";
+        printf("%ld.%06ld\n", last_rtcp_ntp_time_unix.tv_sec, last_rtcp_ntp_time_unix.tv_usec);
+        std::cerr << "last_rtcp_timestamp: " << packet.last_rtcp_timestamp << std::endl;
 #endif
-            }
-            // if no RTSP is used or no RTP timestamp <-> NTP walltime mapping is received, make timestamp from local system time
-            else {
-                auto now = std::chrono::system_clock::now();
-                this->frame_timestamp = std::chrono::duration<double>(now.time_since_epoch()).count();
-            }
-
-            this->frame_number++;
-            valid = true;
 
+        // wait for the first RTCP sender report containing RTP timestamp <-> NTP walltime mapping,
+        // before this no reliable frame timestmap can be computed
+        if (this->is_rtsp && packet.synced) {
+            // compute absolute UNIX timestamp for each frame as follows (90 kHz clock as in RTP spec):
+            // frame_time_unix = last_rtcp_ntp_time_unix + (timestamp - last_rtcp_timestamp) / 90000
+            struct timeval tv;
+            ntp2tv(&packet.last_rtcp_ntp_time, &tv);
+            double rtp_diff = (double)(packet.timestamp - packet.last_rtcp_timestamp) / 90000.0;
+            double timestamp = (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0 + rtp_diff;
+
+            // the decoder may output the frame of this packet only after
+            // reading further packets, so remember the timestamp by pts
+            this->rtcp_timestamps[this->packet.pts] = timestamp;
+            if (this->rtcp_timestamps.size() > max_number_of_timestamps)
+                this->rtcp_timestamps.erase(this->rtcp_timestamps.begin());
         }
-        else {
+
+        // send the packet to the decoder, frames are received at the top of the loop
+        decode_start = std::chrono::steady_clock::now();
+        ret = avcodec_send_packet(this->video_dec_ctx, &(this->packet));
+        this->decode_time += std::chrono::duration<double>(std::chrono::steady_clock::now() - decode_start).count();
+        if (ret < 0) {
             count_errs++;
             if (count_errs > max_number_of_attempts)
                 break;
         }
-
     }
 
     return valid;
 }
 
 
-bool VideoCap::retrieve(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, MVS_DTYPE **motion_vectors, MVS_DTYPE *num_mvs, double *frame_timestamp) {
+int64_t VideoCap::get_start_pts(void) {
+    if (this->first_frame_pts != AV_NOPTS_VALUE)
+        return this->first_frame_pts;
+    if (this->video_stream->start_time != AV_NOPTS_VALUE)
+        return this->video_stream->start_time;
+    return 0;
+}
+
+
+// Returns the index of the received frame in the stream
+int64_t VideoCap::compute_frame_number(void) {
+
+    AVRational frame_rate = this->video_stream->avg_frame_rate;
+    int64_t pts = this->frame->best_effort_timestamp;
+
+    // the index knows the position of each frame, without timestamps frames are counted from the last seek
+    if (this->index.frame_count() > 0) {
+        int64_t frame_number = this->index.frame_number_of_pts(pts);
+        if (frame_number >= 0)
+            return frame_number;
+        return this->frame_number + 1;
+    }
+
+    if (pts == AV_NOPTS_VALUE || frame_rate.num <= 0 || frame_rate.den <= 0)
+        return this->frame_number + 1;
+
+    // live streams do not start at a known timestamp, count from their first frame
+    if (this->first_frame_pts == AV_NOPTS_VALUE) {
+        if (this->video_stream->start_time != AV_NOPTS_VALUE)
+            this->first_frame_pts = this->video_stream->start_time;
+        else
+            this->first_frame_pts = pts;
+    }
+
+    return av_rescale_q(pts - this->first_frame_pts, this->video_stream->time_base, av_inv_q(frame_rate));
+}
+
+
+// Returns the timestamp of the received frame
+double VideoCap::get_frame_timestamp(void) {
+
+    // use the timestamp from the RTCP sender reports of the packet the frame was decoded from
+    if (this->is_rtsp && this->frame->pts != AV_NOPTS_VALUE) {
+        std::map<int64_t, double>::iterator it = this->rtcp_timestamps.find(this->frame->pts);
+        if (it != this->rtcp_timestamps.end()) {
+            double timestamp = it->second;
+            // frames are output in presentation order, earlier entries are not needed anymore
+            this->rtcp_timestamps.erase(this->rtcp_timestamps.begin(), ++it);
+            this->frame_timestamp_synced = true;
+            return timestamp;
+        }
+    }
+
+    this->frame_timestamp_synced = false;
+
+    // media time of the frame, which does not depend on how fast frames are read
+    if (this->options.timestamp_source != TIMESTAMP_SOURCE_SYSTEM) {
+        int64_t pts = this->frame->best_effort_timestamp;
+
+        // frames without timestamp follow one frame duration after the previous frame
+        if (pts == AV_NOPTS_VALUE) {
+            AVRational frame_rate = this->video_stream->avg_frame_rate;
+            if (frame_rate.num <= 0 || frame_rate.den <= 0)
+                return this->frame_timestamp;
+            return this->frame_timestamp + av_q2d(av_inv_q(frame_rate));
+        }
+
+        if (this->video_stream->start_time != AV_NOPTS_VALUE)
+            pts -= this->video_stream->start_time;
+        double timestamp = pts * av_q2d(this->video_stream->time_base);
+
+        // creation_time is in microseconds since the UNIX epoch
+        if (this->creation_time != AV_NOPTS_VALUE)
+            timestamp += this->creation_time / 1000000.0;
+
+        return timestamp;
+    }
+
+    // if no RTSP is used or no RTP timestamp <-> NTP walltime mapping is received, make timestamp from local system time
+    auto now = std::chrono::system_clock::now();
+    return std::chrono::duration<double>(now.time_since_epoch()).count();
+}
+
+
+void VideoCap::get_output_size(int *width, int *height) {
+
+    int src_width = this->frame->width;
+    int src_height = this->frame->height;
+    int out_width = this->options.output_width;
+    int out_height = this->options.output_height;
+
+    // keep the aspect ratio if only one dimension is given
+    if (out_width <= 0 && out_height <= 0) {
+        out_width = src_width;
+        out_height = src_height;
+    }
+    else if (out_width <= 0) {
+        out_width = (int)lround((double)src_width * out_height / src_height);
+    }
+    else if (out_height <= 0) {
+        out_height = (int)lround((double)src_height * out_width / src_width);
+    }
+
+    // chroma planes of 4:2:0 formats have half the resolution
+    if (this->options.output_format == AV_PIX_FMT_NV12 || this->options.output_format == AV_PIX_FMT_YUV420P) {
+        out_width = (out_width + 1) & ~1;
+        out_height = (out_height + 1) & ~1;
+    }
+
+    *width = std::max(out_width, 1);
+    *height = std::max(out_height, 1);
+}
+
+
+bool VideoCap::get_frame_shape(int *width, int *height, int *cn) {
 
     if (!this->video_stream || !(this->frame->data[0]))
         return false;
 
-    if (this->img_convert_ctx == NULL ||
-        this->picture.width != this->video_dec_ctx->width ||
-        this->picture.height != this->video_dec_ctx->height ||
-        this->picture.data == NULL) {
-
-        // Some sws_scale optimizations have some assumptions about alignment of data/step/width/height
-        // Also we use coded_width/height to workaround problem with legacy ffmpeg versions (like n0.8)
-        int buffer_width = this->video_dec_ctx->coded_width;
-        int buffer_height = this->video_dec_ctx->coded_height;
-
-        this->img_convert_ctx = sws_getCachedContext(
-                this->img_convert_ctx,
-                buffer_width, buffer_height,
-                this->video_dec_ctx->pix_fmt,
-                buffer_width, buffer_height,
-                AV_PIX_FMT_BGR24,
-                SWS_BICUBIC,
-                NULL, NULL, NULL
-                );
-
-        if (this->img_convert_ctx == NULL)
-            return false;
+    int out_width, out_height;
+    this->get_output_size(&out_width, &out_height);
+
+    switch (this->options.output_format) {
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_YUV420P:
+            *width = out_width;
+            *height = out_height * 3 / 2;
+            break;
+        default:
+            *width = out_width;
+            *height = out_height;
+            break;
+    }
+    *cn = this->get_frame_channels();
 
-        av_frame_unref(&(this->rgb_frame));
-        this->rgb_frame.format = AV_PIX_FMT_BGR24;
-        this->rgb_frame.width = buffer_width;
-        this->rgb_frame.height = buffer_height;
-        if (0 != av_frame_get_buffer(&(this->rgb_frame), 32))
-            return false;
+    return true;
+}
+
+
+int VideoCap::get_frame_channels(void) {
 
-        this->picture.width = this->video_dec_ctx->width;
-        this->picture.height = this->video_dec_ctx->height;
-        this->picture.data = this->rgb_frame.data[0];
-        this->picture.step = this->rgb_frame.linesize[0];
-        this->picture.cn = 3;
+    switch (this->options.output_format) {
+        case AV_PIX_FMT_GRAY8:
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_YUV420P:
+            return 1;
+        default:
+            return 3;
+    }
+}
+
+
+bool VideoCap::convert_frame(uint8_t *frame, int step) {
+
+    int out_width, out_height;
+    this->get_output_size(&out_width, &out_height);
+
+    // planes of 4:2:0 formats follow each other in the buffer, see get_frame_shape()
+    uint8_t *dst_data[4] = {frame, NULL, NULL, NULL};
+    int dst_linesize[4] = {step, 0, 0, 0};
+    if (this->options.output_format == AV_PIX_FMT_NV12) {
+        dst_data[1] = frame + (size_t)out_height * step;
+        dst_linesize[1] = step;
+    }
+    else if (this->options.output_format == AV_PIX_FMT_YUV420P) {
+        dst_data[1] = frame + (size_t)out_height * step;
+        dst_data[2] = dst_data[1] + (size_t)(out_height / 2) * (step / 2);
+        dst_linesize[1] = step / 2;
+        dst_linesize[2] = step / 2;
     }
 
-    // change color space of frame
+    // rows can only be converted independently if the frame is not scaled vertically
+    int scale_threads = this->options.scale_threads;
+    if (scale_threads == 0)
+        scale_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    if (scale_threads > 1 && out_height == this->frame->height)
+        return this->sliced_scaler.scale(this->frame, dst_data, dst_linesize,
+            out_width, this->options.output_format, this->options.scaler, scale_threads);
+
+    // returns the previous context if none of the parameters changed
+    this->img_convert_ctx = sws_getCachedContext(
+            this->img_convert_ctx,
+            this->frame->width, this->frame->height,
+            (AVPixelFormat)this->frame->format,
+            out_width, out_height,
+            this->options.output_format,
+            this->options.scaler,
+            NULL, NULL, NULL
+            );
+
+    if (this->img_convert_ctx == NULL)
+        return false;
+
+    // change color space and size of frame
     sws_scale(
         this->img_convert_ctx,
         this->frame->data,
         this->frame->linesize,
-        0, this->video_dec_ctx->coded_height,
-        this->rgb_frame.data,
-        this->rgb_frame.linesize
+        0, this->frame->height,
+        dst_data,
+        dst_linesize
         );
 
-    *frame = this->picture.data;
-    *width = this->picture.width;
-    *height = this->picture.height;
-    *step = this->picture.step;
-    *cn = this->picture.cn;
+    return true;
+}
+
+
+bool VideoCap::retrieve(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, void **motion_vectors, int64_t *num_mvs, double *frame_timestamp) {
+
+    if (!this->get_frame_shape(width, height, cn))
+        return false;
+
+    // only motion vectors are retrieved, no buffer for the frame is needed
+    if (!this->options.decode_frames) {
+        *frame = NULL;
+        *step = 0;
+        *width = 0;
+        *height = 0;
+        *cn = 0;
+        return this->retrieve_into(NULL, 0, frame_type, motion_vectors, num_mvs, frame_timestamp);
+    }
+
+    // rows are aligned for SIMD, also the half rows of the YUV420P chroma planes
+    *step = FFALIGN(*width * *cn, 64);
+
+    // (re)allocate the internal frame buffer if the frame grew
+    size_t size = (size_t)*step * *height;
+    if (this->frame_buffer == NULL || this->frame_buffer_size < size) {
+        av_freep(&(this->frame_buffer));
+        this->frame_buffer_size = 0;
+        this->frame_buffer = (uint8_t *)av_malloc(size);
+        if (this->frame_buffer == NULL)
+            return false;
+        this->frame_buffer_size = size;
+    }
+
+    *frame = this->frame_buffer;
+
+    return this->retrieve_into(*frame, *step, frame_type, motion_vectors, num_mvs, frame_timestamp);
+}
+
+
+bool VideoCap::retrieve_into(uint8_t *frame, int step, char *frame_type, void **motion_vectors, int64_t *num_mvs, double *frame_timestamp) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return false;
+
+    // allocate memory for motion vectors as 1D array
+    void *buffer = NULL;
+    int64_t max_mvs = this->count_motion_vectors();
+    if (max_mvs > 0) {
+        if (!(buffer = malloc(max_mvs * motion_vector_size(this->options.mvs_dtype))))
+            return false;
+    }
+
+    if (!this->retrieve_into(frame, step, frame_type, buffer, max_mvs, num_mvs, frame_timestamp)) {
+        free(buffer);
+        return false;
+    }
+
+    if (buffer != NULL)
+        *motion_vectors = buffer;
+
+    return true;
+}
+
+
+bool VideoCap::retrieve_into(uint8_t *frame, int step, char *frame_type, void *motion_vectors, int64_t max_mvs, int64_t *num_mvs, double *frame_timestamp) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return false;
+
+    if (frame != NULL && this->options.decode_frames) {
+        if (!this->convert_frame(frame, step))
+            return false;
+    }
 
     // get motion vectors
+    *num_mvs = 0;
     AVFrameSideData *sd = av_frame_get_side_data(this->frame, AV_FRAME_DATA_MOTION_VECTORS);
     if (sd) {
         AVMotionVector *mvs = (AVMotionVector *)sd->data;
 
         *num_mvs = sd->size / sizeof(*mvs);
 
-        if (*num_mvs > 0) {
-
-            // allocate memory for motion vectors as 1D array
-            if (!(*motion_vectors = (MVS_DTYPE *) malloc(*num_mvs * 10 * sizeof(MVS_DTYPE))))
-                return false;
-
-            // store the motion vectors in the allocated memory (C contiguous)
-            for (MVS_DTYPE i = 0; i < *num_mvs; ++i) {
-                *(*motion_vectors + i*10     ) = static_cast<MVS_DTYPE>(mvs[i].source);
-                *(*motion_vectors + i*10 +  1) = static_cast<MVS_DTYPE>(mvs[i].w);
-                *(*motion_vectors + i*10 +  2) = static_cast<MVS_DTYPE>(mvs[i].h);
-                *(*motion_vectors + i*10 +  3) = static_cast<MVS_DTYPE>(mvs[i].src_x);
-                *(*motion_vectors + i*10 +  4) = static_cast<MVS_DTYPE>(mvs[i].src_y);
-                *(*motion_vectors + i*10 +  5) = static_cast<MVS_DTYPE>(mvs[i].dst_x);
-                *(*motion_vectors + i*10 +  6) = static_cast<MVS_DTYPE>(mvs[i].dst_y);
-                *(*motion_vectors + i*10 +  7) = static_cast<MVS_DTYPE>(mvs[i].motion_x);
-                *(*motion_vectors + i*10 +  8) = static_cast<MVS_DTYPE>(mvs[i].motion_y);
-                *(*motion_vectors + i*10 +  9) = static_cast<MVS_DTYPE>(mvs[i].motion_scale);
-                //*(*motion_vectors + i*11 + 10) = static_cast<MVS_DTYPE>(mvs[i].flags);
-            }
-        }
+        // store as many motion vectors as fit into the buffer (C contiguous)
+        int64_t n = std::min(*num_mvs, max_mvs);
+        pack_motion_vectors(mvs, n, motion_vectors, this->options.mvs_dtype, this->options.mvs_layout, max_mvs);
     }
 
     // get frame type (I, P, B, etc.) and create a null terminated c-string
@@ -344,11 +759,220 @@ bool VideoCap::retrieve(uint8_t **frame, int *step, int *width, int *height, int
     // return the timestamp which was computed previously in grab()
     *frame_timestamp = this->frame_timestamp;
 
+    this->update_latency_stats();
+
+    return true;
+}
+
+
+bool VideoCap::ref_frame(AVFrame **frame, FramePlane *planes, int *num_planes) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return false;
+
+    const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get((AVPixelFormat)this->frame->format);
+    if (!desc || (desc->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_PAL | AV_PIX_FMT_FLAG_BITSTREAM)))
+        return false;
+
+    int count = av_pix_fmt_count_planes((AVPixelFormat)this->frame->format);
+    if (count <= 0 || count > 4)
+        return false;
+
+    for (int p = 0; p < count; p++) {
+        FramePlane *plane = &(planes[p]);
+        int components = 0;
+        int depth = 0;
+        for (int c = 0; c < desc->nb_components; c++) {
+            if (desc->comp[c].plane == p) {
+                components++;
+                depth = desc->comp[c].depth;
+            }
+        }
+
+        // only the chroma planes are subsampled
+        bool chroma = (p == 1 || p == 2) && !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+        plane->height = chroma ? AV_CEIL_RSHIFT(this->frame->height, desc->log2_chroma_h) : this->frame->height;
+        plane->width = chroma ? AV_CEIL_RSHIFT(this->frame->width, desc->log2_chroma_w) : this->frame->width;
+        plane->components = std::max(components, 1);
+        plane->component_size = depth > 8 ? 2 : 1;
+        plane->linesize = this->frame->linesize[p];
+        plane->data = NULL;
+    }
+
+    // only adds a reference to the buffers, the frame data is not copied
+    AVFrame *ref = av_frame_clone(this->frame);
+    if (!ref)
+        return false;
+
+    for (int p = 0; p < count; p++)
+        planes[p].data = ref->data[p];
+
+    *frame = ref;
+    *num_planes = count;
+    return true;
+}
+
+
+int64_t VideoCap::get_frame_number(void) {
+    return this->frame_number;
+}
+
+
+bool VideoCap::seek(int64_t frame_index) {
+
+    if (!this->fmt_ctx || !this->video_stream || frame_index < 0)
+        return false;
+
+    if (this->index.frame_count() > 0)
+        return this->seek_index(frame_index);
+
+    // frame indices are only defined by timestamps if the frame rate is known
+    AVRational frame_rate = this->video_stream->avg_frame_rate;
+    if (frame_rate.num <= 0 || frame_rate.den <= 0)
+        return false;
+
+    int64_t target_pts = this->get_start_pts() + av_rescale_q(frame_index, av_inv_q(frame_rate), this->video_stream->time_base);
+    return this->seek_pts(target_pts, frame_index);
+}
+
+
+bool VideoCap::seek_time(double seconds) {
+
+    if (!this->fmt_ctx || !this->video_stream || seconds < 0)
+        return false;
+
+    AVRational time_base = this->video_stream->time_base;
+    int64_t target_pts = this->get_start_pts() + llround(seconds * time_base.den / time_base.num);
+
+    // the index knows which frame is shown at that time
+    if (this->index.frame_count() > 0 && this->index.has_pts) {
+        int64_t frame_index = this->index.frame_number_after_pts(target_pts);
+        if (frame_index < 0)
+            return false;
+        return this->seek_index(frame_index);
+    }
+
+    return this->seek_pts(target_pts, -1);
+}
+
+
+bool VideoCap::seek_pts(int64_t target_pts, int64_t frame_index) {
+
+    // frame numbers after the seek must refer to the same start as before
+    this->first_frame_pts = this->get_start_pts();
+
+    // jump to the closest keyframe at or before the target, decoding can only start there
+    if (av_seek_frame(this->fmt_ctx, this->video_stream_idx, target_pts, AVSEEK_FLAG_BACKWARD) < 0)
+        return false;
+
+    this->flush_decoder();
+    return this->preroll(target_pts, frame_index);
+}
+
+
+bool VideoCap::seek_index(int64_t frame_index) {
+
+    int32_t entry = this->index.frame_entry(frame_index);
+    if (entry < 0)
+        return false;
+
+    // decoding starts at the keyframe, without one (e.g. in broken files) at the first packet
+    int32_t keyframe = this->index.keyframe_before(entry);
+    if (keyframe < 0)
+        keyframe = 0;
+    const VideoIndexEntry &keyframe_entry = this->index.entries[keyframe];
+
+    // jump directly to the packet of the keyframe, some containers (e.g. MP4) only support seeking by timestamp
+    bool seeked = keyframe_entry.pos >= 0 && !(this->fmt_ctx->iformat->flags & AVFMT_NO_BYTE_SEEK) &&
+        av_seek_frame(this->fmt_ctx, this->video_stream_idx, keyframe_entry.pos, AVSEEK_FLAG_BYTE) >= 0;
+    if (!seeked) {
+        if (!this->index.has_pts)
+            return false;
+        if (av_seek_frame(this->fmt_ctx, this->video_stream_idx, this->index.entries[entry].pts, AVSEEK_FLAG_BACKWARD) < 0)
+            return false;
+    }
+
+    this->flush_decoder();
+
+    // without timestamps frames are counted, start counting at the keyframe
+    if (!this->index.has_pts)
+        this->frame_number = keyframe - 1;
+
+    return this->preroll(AV_NOPTS_VALUE, frame_index);
+}
+
+
+void VideoCap::flush_decoder(void) {
+    // discard frames and packets from before the seek, this also ends draining mode
+    avcodec_flush_buffers(this->video_dec_ctx);
+    av_packet_unref(&(this->packet));
+    this->rtcp_timestamps.clear();
+    this->frame_held = false;
+    this->decode_time = 0.0;
+}
+
+
+bool VideoCap::preroll(int64_t target_pts, int64_t frame_index) {
+
+    // decode up to the target frame, grab() neither converts frames nor copies motion vectors
+    while (this->grab()) {
+        bool reached;
+        if (frame_index >= 0)
+            reached = this->frame_number >= frame_index;
+        else
+            reached = this->frame->best_effort_timestamp != AV_NOPTS_VALUE &&
+                this->frame->best_effort_timestamp >= target_pts;
+
+        // return the target frame on the next call of grab()
+        if (reached) {
+            this->hold_frame();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+int64_t VideoCap::get_frame_count(void) {
+    if (!this->video_stream)
+        return -1;
+    if (this->index.frame_count() > 0)
+        return this->index.frame_count();
+    if (this->video_stream->nb_frames > 0)
+        return this->video_stream->nb_frames;
+    return -1;
+}
+
+
+std::vector<int64_t> VideoCap::get_keyframe_numbers(void) {
+    return this->index.keyframe_numbers();
+}
+
+
+bool VideoCap::get_frame_metadata(FrameMetadata *metadata) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return false;
+
+    metadata->packet_size = this->frame->pkt_size;
+    metadata->pts = this->frame->pts;
+    metadata->dts = this->frame->pkt_dts;
+    metadata->time_base = this->video_stream->time_base;
+    metadata->pos = this->frame->pkt_pos;
+    metadata->key_frame = this->frame->key_frame != 0;
+    metadata->decode_time = this->frame_decode_time;
     return true;
 }
 
 
-bool VideoCap::read(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, MVS_DTYPE **motion_vectors, MVS_DTYPE *num_mvs, double *frame_timestamp) {
+void VideoCap::hold_frame(void) {
+    if (this->video_stream && this->frame->data[0])
+        this->frame_held = true;
+}
+
+
+bool VideoCap::read(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, void **motion_vectors, int64_t *num_mvs, double *frame_timestamp) {
     bool ret = this->grab();
     if (ret)
         ret = this->retrieve(frame, step, width, height, cn, frame_type, motion_vectors, num_mvs, frame_timestamp);
@@ -356,6 +980,100 @@ bool VideoCap::read(uint8_t **frame, int *step, int *width, int *height, int *cn
 }
 
 
+int64_t VideoCap::count_motion_vectors(void) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return 0;
+
+    AVFrameSideData *sd = av_frame_get_side_data(this->frame, AV_FRAME_DATA_MOTION_VECTORS);
+    if (!sd)
+        return 0;
+
+    return sd->size / sizeof(AVMotionVector);
+}
+
+
+const int8_t *VideoCap::get_qp_table(int *width, int *height, int *stride) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return NULL;
+
+    int type;
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    // deprecated since FFmpeg 4.0, but still the way the decoders export QP values
+    const int8_t *table = av_frame_get_qp_table(this->frame, stride, &type);
+#pragma GCC diagnostic pop
+    if (!table)
+        return NULL;
+
+    *width = (this->frame->width + 15) / 16;
+    *height = (this->frame->height + 15) / 16;
+
+    // the MPEG decoders pad rows by one macroblock, other layouts are not supported
+    if (*stride < *width)
+        return NULL;
+
+    return table;
+}
+
+
+bool VideoCap::get_qp_shape(int *width, int *height) {
+    int stride;
+    return this->get_qp_table(width, height, &stride) != NULL;
+}
+
+
+bool VideoCap::retrieve_qp(int8_t *qp, int step) {
+    int width, height, stride;
+    const int8_t *table = this->get_qp_table(&width, &height, &stride);
+    if (!table)
+        return false;
+
+    for (int y = 0; y < height; y++)
+        memcpy(qp + (int64_t)y * step, table + (int64_t)y * stride, width);
+
+    return true;
+}
+
+
+const uint8_t *VideoCap::get_mb_type_table(int *width, int *height) {
+
+    if (!this->video_stream || !(this->frame->data[0]))
+        return NULL;
+
+    AVFrameSideData *sd = av_frame_get_side_data(this->frame, AV_FRAME_DATA_MB_TYPES);
+    if (!sd)
+        return NULL;
+
+    *width = (this->frame->width + 15) / 16;
+    *height = (this->frame->height + 15) / 16;
+
+    if (sd->size < (int64_t)(*width) * (*height))
+        return NULL;
+
+    return sd->data;
+}
+
+
+bool VideoCap::get_mb_type_shape(int *width, int *height) {
+    return this->get_mb_type_table(width, height) != NULL;
+}
+
+
+bool VideoCap::retrieve_mb_types(uint8_t *mb_types, int step) {
+    int width, height;
+    const uint8_t *table = this->get_mb_type_table(&width, &height);
+    if (!table)
+        return false;
+
+    for (int y = 0; y < height; y++)
+        memcpy(mb_types + (int64_t)y * step, table + (int64_t)y * width, width);
+
+    return true;
+}
+
+
 // Returns true if the comma-separated list of format names contains "rtsp"
 bool VideoCap::check_format_rtsp(const char *format_names) {
 
@@ -1,4 +1,7 @@
 #include <thread>
+#include <algorithm>
+#include <map>
+#include <string>
 #include <iostream>
 #include <cstdint>
 #include <chrono>
@@ -10,26 +13,278 @@ extern "C" {
 #include <libavutil/motion_vector.h>
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
+#include <libavutil/pixdesc.h>
+#include <libavutil/parseutils.h>
 }
 
 #include "time_cvt.hpp"
+#include "stream_info_cache.hpp"
+#include "video_index.hpp"
+#include "sliced_scaler.hpp"
+#include "motion_vectors.hpp"
 
 
-// for changing the dtype of motion vector
-#define MVS_DTYPE int32_t
-#define MVS_DTYPE_NP NPY_INT32
-
 // whether or not to print some debug info
 //#define DEBUG
 
 
-struct Image_FFMPEG
+/**
+* Decoding profiles which trade frame quality for decoding speed.
+*
+* - DECODE_PROFILE_FULL: Frames are decoded as specified by the codec.
+* - DECODE_PROFILE_MVS: The decoder skips the inverse DCT and the deblocking
+*       loop filter (as far as the codec supports it). Motion vectors are
+*       parsed from the bitstream before these steps and are exported exactly
+*       as in the full profile. Frame types and timestamps are exact as well.
+*       Decoded frames, however, are not exact and show artifacts which
+*       accumulate until the next keyframe. Use this profile only if frames
+*       are not needed.
+*/
+enum DecodeProfile
 {
-    unsigned char* data;
-    int width;
+    DECODE_PROFILE_FULL,
+    DECODE_PROFILE_MVS
+};
+
+
+/**
+* Sources of the frame timestamps returned by `VideoCap::retrieve`.
+*
+* For RTSP streams whose sender provides RTCP sender reports, the timestamp
+* is always the capture time derived from the sender reports. The source
+* only determines the timestamp of all other frames.
+*
+* - TIMESTAMP_SOURCE_SYSTEM: The current system time when the frame is
+*       grabbed, i.e. the time of reading rather than of capturing.
+* - TIMESTAMP_SOURCE_PTS: The presentation time of the frame in seconds
+*       from the start of the stream, i.e. the presentation timestamp scaled
+*       by the time base of the stream. It does not depend on how fast the
+*       frames are read. Frames without timestamp are placed one frame
+*       duration after the previous frame.
+* - TIMESTAMP_SOURCE_CREATION_TIME: Like TIMESTAMP_SOURCE_PTS, but offset
+*       by the creation time stored in the container (e.g. by cameras in
+*       MP4 files), which gives UNIX timestamps of the capture time. If the
+*       container has no creation time, the timestamps are the same as with
+*       TIMESTAMP_SOURCE_PTS.
+*/
+enum TimestampSource
+{
+    TIMESTAMP_SOURCE_SYSTEM,
+    TIMESTAMP_SOURCE_PTS,
+    TIMESTAMP_SOURCE_CREATION_TIME
+};
+
+
+/**
+* Options which control how a stream is opened and decoded by `VideoCap::open`.
+*/
+struct VideoCapOptions
+{
+    /** Whether frames are converted and returned by `retrieve`. If false,
+    *   only motion vectors, frame type and timestamp are returned, which
+    *   skips the color space conversion and saves the memory for the frame. */
+    bool decode_frames = true;
+
+    /** Which steps of the decoding process are performed, see `DecodeProfile` */
+    DecodeProfile decode_profile = DECODE_PROFILE_FULL;
+
+    /** Number of threads used by the decoder. If 0, the number of CPU cores
+    *   is used, but at most 16 threads as recommended by FFMPEG. Each opened
+    *   stream creates its own threads, so use a smaller number when decoding
+    *   many streams at once. */
+    int thread_count = 0;
+
+    /** Threading method of the decoder. Either FF_THREAD_FRAME,
+    *   FF_THREAD_SLICE or both. Frame threading decodes multiple frames in
+    *   parallel, which scales well but delays the output by one frame per
+    *   thread. Slice threading decodes the slices of one frame in parallel
+    *   and adds no delay, which suits live streams, but requires that the
+    *   encoder produces multiple slices per frame. */
+    int thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+    /** Minimize the delay between capture and output of frames of live
+    *   streams. Disables buffering in the demuxer, shortens stream probing,
+    *   lets the decoder output frames immediately without reordering delay
+    *   and restricts decoder threading to slice threading. Streams with B
+    *   frames may be output in wrong order. */
+    bool low_latency = false;
+
+    /** Decode only keyframes (I frames). All other packets are dropped before
+    *   they reach the decoder, so that `grab` jumps from keyframe to keyframe
+    *   at demuxing speed. Keyframes carry no motion vectors. */
+    bool keyframes_only = false;
+
+    /** Skip decoding of frames which are not referenced by other frames, e.g.
+    *   the B frames of IBBP streams. This roughly halves decoding time of such
+    *   streams. Skipped frames are not returned by `grab`. */
+    bool skip_nonref = false;
+
+    /** Directory of the stream info cache. If not empty, the codec parameters
+    *   of the stream are stored there after the stream was probed. Later opens
+    *   of the same url skip probing with `avformat_find_stream_info` and use
+    *   the cached parameters instead, unless the stream's fingerprint changed
+    *   (see `stream_info_fingerprint`). This shortens opening RTSP streams
+    *   considerably. */
+    std::string stream_info_cache;
+
+    /** Path of the index sidecar of a video file, see `VideoIndex`. If empty,
+    *   `VideoIndex::sidecar_path` of the url is used. If the sidecar exists
+    *   and matches the file, `open` loads it and seeking and frame counting
+    *   use it instead of reading the file. */
+    std::string index_path;
+
+    /** Pixel format of retrieved frames. Supported are `AV_PIX_FMT_BGR24`,
+    *   `AV_PIX_FMT_RGB24`, `AV_PIX_FMT_GRAY8` and the planar 4:2:0 formats
+    *   `AV_PIX_FMT_NV12` and `AV_PIX_FMT_YUV420P`, see `get_frame_shape`
+    *   for the resulting frame layouts. */
+    AVPixelFormat output_format = AV_PIX_FMT_BGR24;
+
+    /** Width and height of retrieved frames in pixels. If both are zero, the
+    *   size of the decoded frame is used. If one of them is zero, it is
+    *   computed from the other one so that the aspect ratio is kept. For the
+    *   4:2:0 formats, width and height are rounded up to even numbers.
+    *   Scaling happens in the same pass as the color space conversion. */
+    int output_width = 0;
+    int output_height = 0;
+
+    /** Scaling algorithm of libswscale, e.g. `SWS_BICUBIC`, `SWS_BILINEAR`,
+    *   `SWS_FAST_BILINEAR` or `SWS_POINT`. Also used for chroma upsampling
+    *   if the frame is not scaled. */
+    int scaler = SWS_BICUBIC;
+
+    /** Number of threads which convert a frame in parallel, see
+    *   `SlicedScaler`. If zero, one thread per CPU core is used. Only frames
+    *   which are not scaled vertically are converted in slices, all other
+    *   frames are converted on the calling thread. */
+    int scale_threads = 1;
+
+    /** Memory layout of retrieved motion vectors, see `MotionVectorLayout` */
+    MotionVectorLayout mvs_layout = MVS_LAYOUT_AOS;
+
+    /** Element type of retrieved motion vectors, see `MotionVectorDtype`.
+    *   MVS_DTYPE_PACKED can not be combined with MVS_LAYOUT_SOA. */
+    MotionVectorDtype mvs_dtype = MVS_DTYPE_INT32;
+
+    /** How frame timestamps are computed, see `TimestampSource` */
+    TimestampSource timestamp_source = TIMESTAMP_SOURCE_SYSTEM;
+};
+
+
+/**
+* Types of the macroblocks of a frame, see `VideoCap::retrieve_mb_types`.
+*
+* Partition sizes are given in pixels of the luma plane. MB_TYPE_INTRA_NXN
+* denotes the I_4x4 and I_8x8 macroblocks of H.264 and all intra macroblocks
+* of MPEG-4 Part 2. MB_TYPE_INTER_8X8 denotes H.264 macroblocks with sub-
+* partitions and MPEG-4 Part 2 macroblocks with four motion vectors.
+*/
+enum MacroblockType
+{
+    MB_TYPE_INTRA_16X16 = 0,
+    MB_TYPE_INTRA_NXN = 1,
+    MB_TYPE_INTRA_PCM = 2,
+    MB_TYPE_SKIP = 3,
+    MB_TYPE_DIRECT = 4,
+    MB_TYPE_INTER_16X16 = 5,
+    MB_TYPE_INTER_16X8 = 6,
+    MB_TYPE_INTER_8X16 = 7,
+    MB_TYPE_INTER_8X8 = 8,
+    MB_TYPE_UNKNOWN = 255
+};
+
+
+/**
+* Memory layout of one plane of a decoded frame, see `VideoCap::ref_frame`.
+*/
+struct FramePlane
+{
+    /** Pointer to the first row of the plane */
+    uint8_t *data;
+
+    /** Number of rows */
     int height;
-    int step;
-    int cn;
+
+    /** Number of pixels per row */
+    int width;
+
+    /** Number of interleaved components per pixel, e.g. 2 for the UV plane of NV12 */
+    int components;
+
+    /** Size of each component in bytes, 1 for 8 bit formats and 2 for higher bit depths */
+    int component_size;
+
+    /** Number of bytes between two consecutive rows */
+    int linesize;
+};
+
+
+/**
+* Metadata of a grabbed frame, see `VideoCap::get_frame_metadata`.
+*
+* All fields except `decode_time` are taken from the compressed packet from
+* which the frame was decoded. With frame reordering (e.g. B frames), this is
+* not the packet read last.
+*/
+struct FrameMetadata
+{
+    /** Size of the compressed packet in bytes, -1 if unknown */
+    int64_t packet_size;
+
+    /** Presentation timestamp in units of `time_base`, AV_NOPTS_VALUE if unknown */
+    int64_t pts;
+
+    /** Decoding timestamp in units of `time_base`, AV_NOPTS_VALUE if unknown */
+    int64_t dts;
+
+    /** Time base of the video stream in seconds */
+    AVRational time_base;
+
+    /** Byte position of the packet in the input, -1 if unknown (e.g. for RTSP streams) */
+    int64_t pos;
+
+    /** Whether the frame is a keyframe, i.e. decoding can start at the frame */
+    bool key_frame;
+
+    /** Wall-clock time in seconds which `grab` spent in the decoder since
+    *   the previous frame, i.e. sending packets to the decoder and receiving
+    *   this frame. Reading packets from the input is not included. With
+    *   frame threading, decoding runs in the background and only the time
+    *   waited for the frame is measured. */
+    double decode_time;
+};
+
+
+/**
+* Runtime statistics of a `VideoCap` object, see `VideoCap::get_stats`.
+*
+* The latency is the time from capturing a frame to returning it from
+* `retrieve`. It is measured only for RTSP streams whose sender provides RTCP
+* sender reports, because the capture time is derived from those (see
+* `retrieve`). The sender and receiver clocks must be synchronized via NTP
+* for the latency to be meaningful.
+*/
+struct VideoCapStats
+{
+    /** Number of frames for which the latency was measured */
+    int64_t latency_count = 0;
+
+    /** Latency of the last frame in seconds */
+    double latency_last = 0.0;
+
+    /** Mean latency of all frames in seconds */
+    double latency_mean = 0.0;
+
+    /** Minimum latency of all frames in seconds */
+    double latency_min = 0.0;
+
+    /** Maximum latency of all frames in seconds */
+    double latency_max = 0.0;
+
+    /** Duration of the last successful call of `open` in seconds */
+    double open_time = 0.0;
+
+    /** Whether the last `open` used cached stream info instead of probing */
+    bool stream_info_cached = false;
 };
 
 
@@ -55,6 +310,7 @@ class VideoCap {
 
 private:
     const char *url;
+    VideoCapOptions options;
     AVDictionary *opts;
     AVCodec *codec;
     AVFormatContext *fmt_ctx;
@@ -63,12 +319,25 @@ private:
     int video_stream_idx;
     AVPacket packet;
     AVFrame *frame;
-    AVFrame rgb_frame;
-    Image_FFMPEG picture;
+    uint8_t *frame_buffer;
+    size_t frame_buffer_size;
     struct SwsContext *img_convert_ctx;
+    SlicedScaler sliced_scaler;
     int64_t frame_number;
+    int64_t first_frame_pts;
     double frame_timestamp;
+    bool frame_timestamp_synced;
+    int64_t creation_time;
+    double decode_time;
+    double frame_decode_time;
+    VideoCapStats stats;
     bool is_rtsp;
+    bool frame_held;
+    std::map<int64_t, double> rtcp_timestamps;
+    std::string stream_info_path;
+    StreamInfo stream_info;
+    bool stream_info_verified;
+    VideoIndex index;
 #if USE_AV_INTERRUPT_CALLBACK
     AVInterruptCallbackMetadata interrupt_metadata;
 #endif
@@ -84,6 +353,68 @@ private:
     */
     bool check_format_rtsp(const char *format_names);
 
+    /** Returns the timestamp of the frame received from the decoder
+    *
+    * For RTSP streams this is the wall time derived from the RTCP sender
+    * reports of the packet from which the frame was decoded. Otherwise, and
+    * as long as no sender report has been received, the timestamp is taken
+    * from the source selected by `VideoCapOptions::timestamp_source`.
+    */
+    double get_frame_timestamp(void);
+
+    /** Returns the presentation timestamp at which frame numbering starts */
+    int64_t get_start_pts(void);
+
+    /** Discards all frames and packets in the decoder after seeking */
+    void flush_decoder(void);
+
+    /** Decodes up to the frame with index `frame_index` if it is not
+    *   negative, otherwise up to the frame with presentation timestamp
+    *   `target_pts`, and holds it for the next call of `grab` */
+    bool preroll(int64_t target_pts, int64_t frame_index);
+
+    /** Seeks to the frame with index `frame_index` using the loaded index */
+    bool seek_index(int64_t frame_index);
+
+    /** Seeks to the keyframe before `target_pts` and decodes up to the frame
+    *   with index `frame_index` if it is not negative, otherwise up to the
+    *   frame with presentation timestamp `target_pts` */
+    bool seek_pts(int64_t target_pts, int64_t frame_index);
+
+    /** Computes the index of the received frame, see `get_frame_number` */
+    int64_t compute_frame_number(void);
+
+    /** Adds the latency of the retrieved frame to the statistics */
+    void update_latency_stats(void);
+
+    /** Removes the cached stream info if the first frame does not match it */
+    void verify_stream_info(void);
+
+    /** Computes the size of retrieved frames from the options */
+    void get_output_size(int *width, int *height);
+
+    /** Returns the QP table exported by the decoder for the grabbed frame and
+    *   its size in macroblocks, or NULL if the decoder exported none */
+    const int8_t *get_qp_table(int *width, int *height, int *stride);
+
+    /** Returns the macroblock types exported by the decoder for the grabbed
+    *   frame and their size in macroblocks, or NULL if the decoder exported
+    *   none. Rows are not padded. */
+    const uint8_t *get_mb_type_table(int *width, int *height);
+
+    /** Converts and scales the grabbed frame to the output format and size
+    *   and writes it into `frame`
+    *
+    * @param frame Pointer to a buffer of shape (height, width, cn) as returned
+    *     by `get_frame_shape`.
+    *
+    * @param step Number of bytes between two consecutive rows of `frame`.
+    *
+    * @retval true if the conversion succeeded, false otherwise.
+    */
+    bool convert_frame(uint8_t *frame, int step);
+
+
 
 public:
 
@@ -103,13 +434,26 @@ public:
     *     file located in the same directory as the source files. Or
     *     "rtsp://xxx.xxx.xxx.xxx:554" for an IP camera streaming via RTSP.
     *
+    * @param options Options which control how the stream is decoded.
+    *
     * @retval true if video file or url could be opened sucessfully, false
     *     otherwise.
     */
-    bool open(const char *url);
+    bool open(const char *url, const VideoCapOptions &options = VideoCapOptions());
+
+    /** Returns the options the stream was opened with */
+    const VideoCapOptions &get_options(void);
+
+    /** Returns runtime statistics of the opened stream, see `VideoCapStats` */
+    VideoCapStats get_stats(void);
 
     /** Reads the next video frame and motion vectors from the stream
     *
+    * Packets are read from the stream until the decoder outputs the next
+    * frame. At the end of the stream the decoder is drained, so that frames
+    * which are still buffered in the decoder (e.g. due to frame threading)
+    * are returned as well.
+    *
     * @retval true if a new video frame could be read and decoded, false
     *    otherwise (e.g. at the end of the stream).
     */
@@ -118,18 +462,20 @@ public:
     /** Decodes and returns the grabbed frame and motion vectors
     *
     * @param frame Pointer to the raw data of the decoded video frame. The
-    *    frame is stored as a C contiguous array of shape (height, width, 3) and
-    *    can be converted into a cv::Mat by using the constructor
-    *    `cv::Mat cv_frame(height, width, CV_MAKETYPE(CV_8U, 3), frame)`.
+    *    frame is stored as a C contiguous array of shape (height, width, cn)
+    *    (see `get_frame_shape`) and can be converted into a cv::Mat by using
+    *    the constructor `cv::Mat cv_frame(height, width, CV_MAKETYPE(CV_8U, cn), frame)`.
+    *    If the stream was opened with `decode_frames` set to false, `frame`
+    *    is set to NULL and `width`, `height`, `step` and `cn` to zero.
     *    Note: A subsequent call of `retrieve` will reuse the same memory for
     *          storing the new frame. If you want a frame to persist for a longer
     *          perdiod of time, allocate a new array and memcopy the raw frame
     *          data into it. After usage you have to manually free this copied
     *          array.
     *
-    * @param width Width of the returned frame in pixels.
+    * @param width Number of columns of the returned frame, see `get_frame_shape`.
     *
-    * @param height Height of the returned frame in pixels.
+    * @param height Number of rows of the returned frame, see `get_frame_shape`.
     *
     * @param frame_type Either "P", "B" or "I" indicating whether it is an
     *    intra-coded frame (I), a predicted frame with only references to past
@@ -139,9 +485,14 @@ public:
     * @param motion_vectors Pointer to the raw data of the motion vectors
     *    belonging to the decoded frame. The motion vectors are stored as a
     *    C contiguous array of shape (num_mvs, 10). Each row of the array
-    *    corresponds to one motion vector. The columns of each vector have the
-    *    following meaning (also refer to AVMotionVector in FFMPEG
-    *    documentation):
+    *    corresponds to one motion vector. If the `mvs_layout` option is
+    *    MVS_LAYOUT_SOA, the array is transposed to shape (10, num_mvs)
+    *    instead, so that each row contains one field of all motion vectors.
+    *    The elements are of type int32_t, unless the `mvs_dtype` option
+    *    selects another type (see `MotionVectorDtype`). With MVS_DTYPE_PACKED
+    *    the array consists of num_mvs `PackedMotionVector` structures.
+    *    The columns of each vector have the following meaning (also refer to
+    *    AVMotionVector in FFMPEG documentation):
     *    - 0: source: Where the current macroblock comes from. Negative value
     *                 when it comes from the past, positive value when it comes
     *                 from the future.
@@ -171,7 +522,9 @@ public:
     *
     * @param frame_timestamp UTC wall time of each frame in the format of a UNIX
     *    timestamp. In case, input is a video file, the timestamp is derived
-    *    from the system time. If the input is an RTSP stream the timestamp
+    *    from the system time, or from the presentation time of the frame,
+    *    depending on `VideoCapOptions::timestamp_source` (see
+    *    `TimestampSource`). If the input is an RTSP stream the timestamp
     *    marks the time the frame was sent out by the sender (e.g. IP camera).
     *    Thus, the timestamp represents the wall time at which the frame was
     *    taken rather then the time at which the frame was received. This allows
@@ -186,11 +539,267 @@ public:
     * @retval true if the grabbed video frame and motion vectors could be
     *    decoded and returned successfully, false otherwise.
     */
-    bool retrieve(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, MVS_DTYPE **motion_vectors, MVS_DTYPE *num_mvs, double *frame_timestamp);
+    bool retrieve(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, void **motion_vectors, int64_t *num_mvs, double *frame_timestamp);
+
+    /** Returns the shape of the frame which `retrieve_into` would write
+    *
+    * Use this method after a successful call of `grab` to allocate a buffer
+    * of suitable size before calling `retrieve_into`. The shape depends on
+    * `VideoCapOptions::output_format`:
+    *   - BGR24 and RGB24: (h, w, 3)
+    *   - GRAY8: (h, w, 1)
+    *   - NV12: (h * 3 / 2, w, 1), the full resolution Y plane followed by
+    *     h / 2 rows of interleaved U and V samples
+    *   - YUV420P: (h * 3 / 2, w, 1), the full resolution Y plane followed by
+    *     the U plane and the V plane, each of size (h / 2, w / 2) with rows
+    *     of `step / 2` bytes
+    * Here, w and h are the output width and height in pixels.
+    *
+    * @param width Number of columns of the retrieved frame.
+    *
+    * @param height Number of rows of the retrieved frame.
+    *
+    * @param cn Number of channels of the retrieved frame.
+    *
+    * @retval true if a frame has been grabbed, false otherwise.
+    */
+    bool get_frame_shape(int *width, int *height, int *cn);
+
+    /** Returns the number of channels of retrieved frames
+    *
+    * Other than `get_frame_shape` this does not require a grabbed frame, as
+    * the number of channels depends only on `VideoCapOptions::output_format`.
+    */
+    int get_frame_channels(void);
+
+    /** Returns the number of motion vectors of the grabbed frame
+    *
+    * Can be used after a successful call of `grab` to size the buffer passed
+    * to `retrieve_into`.
+    */
+    int64_t count_motion_vectors(void);
+
+    /** Returns the size of the QP map of the grabbed frame
+    *
+    * The QP map holds one quantization parameter per 16x16 macroblock, i.e.
+    * it has ceil(h / 16) rows and ceil(w / 16) columns, where w and h are the
+    * width and height of the decoded frame.
+    *
+    * @param width Number of macroblock columns.
+    *
+    * @param height Number of macroblock rows.
+    *
+    * @retval true if the decoder exported a QP map for the grabbed frame,
+    *    false otherwise. QP maps are exported by the MPEG-1, MPEG-2 and
+    *    MPEG-4 Part 2 decoders and, with the patched FFmpeg, by the H.264
+    *    decoder.
+    */
+    bool get_qp_shape(int *width, int *height);
+
+    /** Copies the QP map of the grabbed frame into caller-provided memory
+    *
+    * The values are the quantizers as coded in the bitstream, that is the QP
+    * (0 to 51) for H.264 and the quantizer scale (1 to 31) for MPEG-1, MPEG-2
+    * and MPEG-4 Part 2. Macroblocks which were skipped or not decoded keep
+    * the value the decoder assigned to them, e.g. the QP of the previous
+    * macroblock for H.264.
+    *
+    * @param qp Pointer to a buffer of at least `height` rows of `step` bytes
+    *    each, where `width` and `height` are obtained from `get_qp_shape`.
+    *
+    * @param step Number of bytes between two consecutive rows of `qp`.
+    *
+    * @retval true on success, false if no QP map is available, see
+    *    `get_qp_shape`.
+    */
+    bool retrieve_qp(int8_t *qp, int step);
+
+    /** Returns the size of the macroblock type map of the grabbed frame
+    *
+    * Like the QP map (see `get_qp_shape`), the map holds one value per
+    * 16x16 macroblock.
+    *
+    * @param width Number of macroblock columns.
+    *
+    * @param height Number of macroblock rows.
+    *
+    * @retval true if the decoder exported macroblock types for the grabbed
+    *    frame, false otherwise. Macroblock types are exported by the H.264
+    *    and MPEG-4 Part 2 decoders of the patched FFmpeg.
+    */
+    bool get_mb_type_shape(int *width, int *height);
+
+    /** Copies the macroblock types of the grabbed frame into caller-provided memory
+    *
+    * The types are parsed from the bitstream together with the motion
+    * vectors, so that they are available right after `grab` without
+    * converting the frame. Together with the motion vectors they tell apart
+    * macroblocks without motion from intra coded and skipped ones.
+    *
+    * @param mb_types Pointer to a buffer of at least `height` rows of `step`
+    *    bytes each, where `width` and `height` are obtained from
+    *    `get_mb_type_shape`. Each byte is set to a `MacroblockType`.
+    *
+    * @param step Number of bytes between two consecutive rows of `mb_types`.
+    *
+    * @retval true on success, false if no macroblock types are available,
+    *    see `get_mb_type_shape`.
+    */
+    bool retrieve_mb_types(uint8_t *mb_types, int step);
+
+    /** Returns metadata of the grabbed frame, such as the size of its packet
+    *
+    * The metadata is available right after `grab` and costs nothing to
+    * obtain. For example, the packet size is a cheap measure of the activity
+    * in a frame, which can be used to decide whether to call `retrieve`.
+    *
+    * @param metadata Set to the metadata of the grabbed frame.
+    *
+    * @retval true if a frame has been grabbed, false otherwise.
+    */
+    bool get_frame_metadata(FrameMetadata *metadata);
+
+    /** Keeps the grabbed frame for the next call of `grab`
+    *
+    * The next call of `grab` does not read a new frame from the stream, but
+    * returns true and leaves the currently grabbed frame in place. This
+    * allows to look at a grabbed frame, e.g. with `get_frame_shape`, and
+    * defer retrieving it.
+    */
+    void hold_frame(void);
+
+    /** Returns a new reference to the grabbed frame in the decoder's pixel format
+    *
+    * The returned frame shares its buffers with the decoder, so that the
+    * planes can be accessed without any conversion or copy. Unlike the frame
+    * retrieved by `retrieve`, it stays valid when the next frame is grabbed,
+    * because the decoder allocates buffers for new frames from its buffer
+    * pool while referenced buffers are in use. The buffers must not be
+    * modified, since the decoder may still use them as reference for other
+    * frames.
+    *
+    * @param frame Set to the new reference. The caller has to release it
+    *    with `av_frame_free`.
+    *
+    * @param planes Array of four planes, whose first `num_planes` elements
+    *    are set to the layout of the planes of the frame.
+    *
+    * @param num_planes Set to the number of planes of the frame.
+    *
+    * @retval true on success, false if no frame has been grabbed or the pixel
+    *    format is not supported (hardware, palette and bitstream formats).
+    */
+    bool ref_frame(AVFrame **frame, FramePlane *planes, int *num_planes);
+
+    /** Returns the index of the grabbed frame in the stream
+    *
+    * The index is derived from the presentation timestamp of the frame and
+    * the frame rate of the stream, so that it stays correct if frames are
+    * skipped, e.g. with `VideoCapOptions::skip_nonref`. For streams with
+    * variable frame rate it is approximate. If the stream has no timestamps
+    * or frame rate, the grabbed frames are counted instead. Returns -1 if
+    * no frame has been grabbed yet.
+    */
+    int64_t get_frame_number(void);
+
+    /** Seeks to the frame with the given index
+    *
+    * Seeks to the keyframe preceding the frame and decodes all frames from
+    * there up to the requested one. These pre-roll frames are only decoded,
+    * neither converted nor are their motion vectors copied. The next call of
+    * `grab` (or `read`) returns the requested frame. If frames are skipped
+    * (e.g. with `VideoCapOptions::keyframes_only`), the next call of `grab`
+    * returns the first frame which is not skipped at or after the requested
+    * one. Afterwards, `get_frame_number` continues from the requested index.
+    *
+    * @param frame_index Zero-based index of the frame to seek to (see
+    *   `get_frame_number`).
+    *
+    * If an index sidecar was loaded (see `VideoCapOptions::index_path`), the
+    * keyframe is looked up in the index and the demuxer jumps directly to its
+    * byte position if the container supports it. The stream then needs no
+    * timestamps or frame rate.
+    *
+    * @retval true if the frame was found, false if the stream is not seekable,
+    *   has no timestamps or frame rate, or the index is beyond its end.
+    */
+    bool seek(int64_t frame_index);
+
+    /** Seeks to the given time
+    *
+    * Like `seek`, but the next call of `grab` returns the first frame whose
+    * presentation time is at or after the given time.
+    *
+    * @param seconds Time to seek to in seconds from the start of the stream.
+    *
+    * @retval true if a frame was found, false if the stream is not seekable,
+    *   has no timestamps, or the time is beyond its end.
+    */
+    bool seek_time(double seconds);
+
+    /** Returns the number of frames of the opened video
+    *
+    * If an index sidecar was loaded (see `VideoCapOptions::index_path`), the
+    * count is exact. Otherwise, the number of frames given by the container
+    * is returned, which is missing or wrong for some formats, e.g. MPEG-TS or
+    * raw H.264. Returns -1 if the number of frames is unknown.
+    */
+    int64_t get_frame_count(void);
+
+    /** Returns the indices of all keyframes of the opened video
+    *
+    * Requires a loaded index sidecar, otherwise the list is empty.
+    */
+    std::vector<int64_t> get_keyframe_numbers(void);
+
+    /** Decodes the grabbed frame and motion vectors into caller-provided memory
+    *
+    * Works like `retrieve`, except that the color space conversion writes the
+    * frame directly into `frame` instead of into an internal buffer. This
+    * avoids copying the frame a second time, e.g. when the frame is handed
+    * over to another library which owns the memory.
+    *
+    * @param frame Pointer to a buffer of at least `height` rows of `step`
+    *    bytes each, where `height` is obtained from `get_frame_shape`. Every
+    *    row must have room for `width * cn` bytes. If `frame` is NULL or the
+    *    stream was opened with `decode_frames` set to false, the color space
+    *    conversion is skipped and only motion vectors, frame type and
+    *    timestamp are returned.
+    *
+    * @param step Number of bytes between two consecutive rows of `frame`.
+    *
+    *   The remaining parameters and the return value correspond to the
+    *   `retrieve` method.
+    */
+    bool retrieve_into(uint8_t *frame, int step, char *frame_type, void **motion_vectors, int64_t *num_mvs, double *frame_timestamp);
+
+    /** Decodes the grabbed frame and motion vectors into caller-provided memory
+    *
+    * Works like the other overload of `retrieve_into`, except that also the
+    * motion vectors are stored in a caller-provided buffer instead of newly
+    * allocated memory. Reusing the same buffers for every frame avoids any
+    * heap allocation per frame.
+    *
+    * @param motion_vectors Pointer to a C contiguous buffer of shape
+    *    (max_mvs, 10). The first min(num_mvs, max_mvs) rows are filled with
+    *    the motion vectors of the frame. The columns are the same as described
+    *    for `retrieve`. With the MVS_LAYOUT_SOA layout, the buffer has shape
+    *    (10, max_mvs) and the first min(num_mvs, max_mvs) columns are filled.
+    *
+    * @param max_mvs Number of motion vectors which fit into `motion_vectors`.
+    *
+    * @param num_mvs The number of motion vectors of the frame. This may be
+    *    larger than `max_mvs`, in which case only the first `max_mvs` motion
+    *    vectors were stored and a larger buffer is required to obtain all.
+    *
+    *   The remaining parameters and the return value correspond to the other
+    *   overload of `retrieve_into`.
+    */
+    bool retrieve_into(uint8_t *frame, int step, char *frame_type, void *motion_vectors, int64_t max_mvs, int64_t *num_mvs, double *frame_timestamp);
 
     /** Convenience wrapper which combines a call of `grab` and `retrieve`.
     *
     *   The parameters and return value correspond to the `retrieve` method.
     */
-    bool read(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, MVS_DTYPE **motion_vectors, MVS_DTYPE *num_mvs, double *frame_timestamp);
+    bool read(uint8_t **frame, int *step, int *width, int *height, int *cn, char *frame_type, void **motion_vectors, int64_t *num_mvs, double *frame_timestamp);
 };
@@ -0,0 +1,333 @@
+#include "video_index.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include <sys/stat.h>
+
+
+static const char index_magic[8] = {'M', 'V', 'I', 'D', 'X', '\0', '\0', '\0'};
+static const uint32_t index_version = 1;
+
+
+struct VideoIndexHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t entry_size;
+    int64_t file_size;
+    int64_t file_mtime;
+    int32_t stream_index;
+    int32_t time_base_num;
+    int32_t time_base_den;
+    int32_t reserved;
+    int64_t num_entries;
+};
+
+
+static bool get_file_stat(const char *url, int64_t *size, int64_t *mtime) {
+    struct stat st;
+    if (stat(url, &st) != 0)
+        return false;
+    *size = (int64_t)st.st_size;
+    *mtime = (int64_t)st.st_mtime;
+    return true;
+}
+
+
+VideoIndex::VideoIndex() {
+    this->clear();
+}
+
+
+void VideoIndex::clear(void) {
+    this->stream_index = -1;
+    this->time_base = {0, 1};
+    this->file_size = 0;
+    this->file_mtime = 0;
+    this->has_pts = false;
+    this->entries.clear();
+    this->presentation_order.clear();
+    this->keyframes.clear();
+}
+
+
+int64_t VideoIndex::frame_count(void) const {
+    return (int64_t)this->entries.size();
+}
+
+
+bool VideoIndex::build(const char *url) {
+
+    bool valid = false;
+    AVFormatContext *fmt_ctx = NULL;
+    AVCodecContext *dec_ctx = NULL;
+    AVCodecParserContext *parser = NULL;
+    AVCodec *codec = NULL;
+    AVStream *st = NULL;
+    AVPacket packet;
+    int idx;
+
+    this->clear();
+
+    memset(&packet, 0, sizeof(packet));
+    av_init_packet(&packet);
+
+    if (!get_file_stat(url, &(this->file_size), &(this->file_mtime)))
+        goto error;
+
+    if (avformat_open_input(&fmt_ctx, url, NULL, NULL) < 0)
+        goto error;
+
+    if (avformat_find_stream_info(fmt_ctx, NULL) < 0)
+        goto error;
+
+    idx = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, &codec, 0);
+    if (idx < 0)
+        goto error;
+
+    st = fmt_ctx->streams[idx];
+    this->stream_index = idx;
+    this->time_base = st->time_base;
+
+    // the parser needs a codec context for the extradata (e.g. SPS/PPS of H.264 in MP4 files)
+    dec_ctx = avcodec_alloc_context3(codec);
+    if (!dec_ctx)
+        goto error;
+
+    if (avcodec_parameters_to_context(dec_ctx, st->codecpar) < 0)
+        goto error;
+
+    // determines the frame type from the packet headers, the demuxer already split the stream into frames
+    parser = av_parser_init(st->codecpar->codec_id);
+    if (parser)
+        parser->flags |= PARSER_FLAG_COMPLETE_FRAMES;
+
+    // only demux, packets are never decoded
+    while (av_read_frame(fmt_ctx, &packet) >= 0) {
+        if (packet.stream_index == idx) {
+            VideoIndexEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.pos = packet.pos;
+            entry.pts = packet.pts;
+            entry.dts = packet.dts;
+            entry.size = packet.size;
+            entry.key_frame = (packet.flags & AV_PKT_FLAG_KEY) ? 1 : 0;
+            entry.frame_type = '?';
+
+            if (parser) {
+                uint8_t *out_data = NULL;
+                int out_size = 0;
+                av_parser_parse2(parser, dec_ctx, &out_data, &out_size,
+                    packet.data, packet.size, packet.pts, packet.dts, packet.pos);
+                if (out_size > 0)
+                    entry.frame_type = av_get_picture_type_char((enum AVPictureType)parser->pict_type);
+            }
+
+            this->entries.push_back(entry);
+        }
+        av_packet_unref(&packet);
+    }
+
+    this->update_lookup_tables();
+    valid = !this->entries.empty();
+
+error:
+
+    av_packet_unref(&packet);
+
+    if (parser)
+        av_parser_close(parser);
+
+    if (dec_ctx)
+        avcodec_free_context(&dec_ctx);
+
+    if (fmt_ctx)
+        avformat_close_input(&fmt_ctx);
+
+    if (!valid)
+        this->clear();
+
+    return valid;
+}
+
+
+bool VideoIndex::load(const std::string &path, const char *url) {
+
+    VideoIndexHeader header;
+    int64_t index_size, index_mtime, entries_size;
+    bool valid = false;
+
+    this->clear();
+
+    FILE *file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    if (fread(&header, sizeof(header), 1, file) != 1)
+        goto error;
+
+    if (memcmp(header.magic, index_magic, sizeof(index_magic)) != 0 ||
+        header.version != index_version ||
+        header.entry_size != sizeof(VideoIndexEntry) ||
+        header.num_entries <= 0 ||
+        header.time_base_num <= 0 || header.time_base_den <= 0)
+        goto error;
+
+    // the entries must fill the rest of the file, so that a truncated or
+    // corrupt index is rejected before allocating memory for its entries
+    if (!get_file_stat(path.c_str(), &index_size, &index_mtime))
+        goto error;
+    entries_size = index_size - (int64_t)sizeof(header);
+    if (entries_size % (int64_t)sizeof(VideoIndexEntry) != 0 ||
+        entries_size / (int64_t)sizeof(VideoIndexEntry) != header.num_entries)
+        goto error;
+
+    // the index is stale if the video changed since it was built
+    if (url) {
+        int64_t file_size, file_mtime;
+        if (!get_file_stat(url, &file_size, &file_mtime) ||
+            file_size != header.file_size || file_mtime != header.file_mtime)
+            goto error;
+    }
+
+    this->stream_index = header.stream_index;
+    this->time_base = {header.time_base_num, header.time_base_den};
+    this->file_size = header.file_size;
+    this->file_mtime = header.file_mtime;
+
+    this->entries.resize((size_t)header.num_entries);
+    if (fread(this->entries.data(), sizeof(VideoIndexEntry), this->entries.size(), file) != this->entries.size())
+        goto error;
+
+    this->update_lookup_tables();
+    valid = true;
+
+error:
+
+    fclose(file);
+
+    if (!valid)
+        this->clear();
+
+    return valid;
+}
+
+
+bool VideoIndex::save(const std::string &path) const {
+
+    VideoIndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, index_magic, sizeof(index_magic));
+    header.version = index_version;
+    header.entry_size = sizeof(VideoIndexEntry);
+    header.file_size = this->file_size;
+    header.file_mtime = this->file_mtime;
+    header.stream_index = this->stream_index;
+    header.time_base_num = this->time_base.num;
+    header.time_base_den = this->time_base.den;
+    header.num_entries = (int64_t)this->entries.size();
+
+    // write into a temporary file first and rename it, so that readers never see a partial index
+    std::string tmp_path = path + ".tmp" + std::to_string(getpid());
+
+    FILE *file = fopen(tmp_path.c_str(), "wb");
+    if (!file)
+        return false;
+
+    bool valid = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(this->entries.data(), sizeof(VideoIndexEntry), this->entries.size(), file) == this->entries.size();
+
+    if (fclose(file) != 0)
+        valid = false;
+
+    if (valid && std::rename(tmp_path.c_str(), path.c_str()) != 0)
+        valid = false;
+
+    if (!valid)
+        std::remove(tmp_path.c_str());
+
+    return valid;
+}
+
+
+int32_t VideoIndex::frame_entry(int64_t n) const {
+    if (n < 0 || n >= (int64_t)this->presentation_order.size())
+        return -1;
+    return this->presentation_order[n];
+}
+
+
+int64_t VideoIndex::frame_number_of_pts(int64_t pts) const {
+    int64_t n = this->frame_number_after_pts(pts);
+    if (n < 0 || this->entries[this->presentation_order[n]].pts != pts)
+        return -1;
+    return n;
+}
+
+
+int64_t VideoIndex::frame_number_after_pts(int64_t pts) const {
+    if (!this->has_pts)
+        return -1;
+
+    // presentation_order is sorted by pts
+    const std::vector<VideoIndexEntry> &entries = this->entries;
+    auto it = std::lower_bound(this->presentation_order.begin(), this->presentation_order.end(), pts,
+        [&entries](int32_t entry, int64_t value) { return entries[entry].pts < value; });
+
+    if (it == this->presentation_order.end())
+        return -1;
+
+    return it - this->presentation_order.begin();
+}
+
+
+std::vector<int64_t> VideoIndex::keyframe_numbers(void) const {
+    std::vector<int64_t> numbers;
+    numbers.reserve(this->keyframes.size());
+    for (int32_t entry : this->keyframes) {
+        if (this->has_pts)
+            numbers.push_back(this->frame_number_of_pts(this->entries[entry].pts));
+        else
+            numbers.push_back(entry);
+    }
+    std::sort(numbers.begin(), numbers.end());
+    return numbers;
+}
+
+
+int32_t VideoIndex::keyframe_before(int32_t entry) const {
+    auto it = std::upper_bound(this->keyframes.begin(), this->keyframes.end(), entry);
+    if (it == this->keyframes.begin())
+        return -1;
+    return *(--it);
+}
+
+
+std::string VideoIndex::sidecar_path(const char *url) {
+    return std::string(url) + ".mvidx";
+}
+
+
+void VideoIndex::update_lookup_tables(void) {
+
+    this->presentation_order.resize(this->entries.size());
+    this->keyframes.clear();
+    this->has_pts = true;
+
+    for (size_t i = 0; i < this->entries.size(); i++) {
+        this->presentation_order[i] = (int32_t)i;
+        if (this->entries[i].key_frame)
+            this->keyframes.push_back((int32_t)i);
+        if (this->entries[i].pts == AV_NOPTS_VALUE)
+            this->has_pts = false;
+    }
+
+    // without timestamps (e.g. some raw H.264 streams) assume that frames are not reordered
+    if (this->has_pts) {
+        const std::vector<VideoIndexEntry> &entries = this->entries;
+        std::stable_sort(this->presentation_order.begin(), this->presentation_order.end(),
+            [&entries](int32_t a, int32_t b) { return entries[a].pts < entries[b].pts; });
+    }
+}
@@ -0,0 +1,141 @@
+#include <string>
+#include <vector>
+#include <cstdint>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+
+/**
+* One packet of the video stream in a `VideoIndex`.
+*/
+struct VideoIndexEntry
+{
+    /** Byte position of the packet in the file, -1 if unknown */
+    int64_t pos;
+
+    /** Presentation timestamp of the packet in stream time base */
+    int64_t pts;
+
+    /** Decoding timestamp of the packet in stream time base */
+    int64_t dts;
+
+    /** Size of the packet in bytes */
+    int32_t size;
+
+    /** Whether the packet contains a keyframe */
+    uint8_t key_frame;
+
+    /** Frame type as determined by the parser, e.g. 'I', 'P', 'B' or '?' */
+    char frame_type;
+
+    uint8_t reserved[2];
+};
+
+
+/**
+* Index of all packets of the video stream of a video file.
+*
+* The index is built in a single pass over the file which only demuxes and
+* parses packets, but does not decode them. It is stored as a binary sidecar
+* file next to the video (see `sidecar_path`), which `VideoCap` loads on
+* `open` to answer seeks and frame count queries without reading the file.
+*
+* The sidecar starts with a header containing a magic number, the format
+* version, the size and modification time of the video file (to detect
+* stale indices), the index of the video stream and its time base. It is
+* followed by one `VideoIndexEntry` per packet in decoding order. All values
+* are stored in native byte order.
+*/
+class VideoIndex
+{
+public:
+    /** Index of the indexed video stream in the file */
+    int stream_index;
+
+    /** Time base of the timestamps */
+    AVRational time_base;
+
+    /** Size of the indexed file in bytes */
+    int64_t file_size;
+
+    /** Modification time of the indexed file in seconds since the epoch */
+    int64_t file_mtime;
+
+    /** Packets of the video stream in decoding order */
+    std::vector<VideoIndexEntry> entries;
+
+    /** Whether all packets have a presentation timestamp. If not, the
+    *   presentation order is assumed to be the decoding order. */
+    bool has_pts;
+
+    /** Indices into `entries` sorted by presentation timestamp, i.e. entry
+    *   `entries[presentation_order[n]]` is the n-th frame of the video */
+    std::vector<int32_t> presentation_order;
+
+    /** Indices into `entries` of all keyframes in ascending order */
+    std::vector<int32_t> keyframes;
+
+    VideoIndex();
+
+    /** Removes all entries */
+    void clear(void);
+
+    /** Returns the number of frames in the index */
+    int64_t frame_count(void) const;
+
+    /** Builds the index of a video file
+    *
+    * @param url Path of the video file.
+    *
+    * @retval true on success, false if the file could not be opened or
+    *   contains no video stream.
+    */
+    bool build(const char *url);
+
+    /** Loads the index from a sidecar file
+    *
+    * @param path Path of the sidecar file.
+    *
+    * @param url Path of the indexed video file. If not NULL, the index is only
+    *   loaded if size and modification time of this file match the index.
+    *
+    * @retval true if the index was loaded, false if the sidecar does not
+    *   exist, is invalid or stale.
+    */
+    bool load(const std::string &path, const char *url);
+
+    /** Stores the index in a sidecar file
+    *
+    * @retval true on success, false otherwise.
+    */
+    bool save(const std::string &path) const;
+
+    /** Returns the index into `entries` of the n-th frame in presentation
+    *   order, or -1 if `n` is out of range */
+    int32_t frame_entry(int64_t n) const;
+
+    /** Returns the index in presentation order of the frame with the given
+    *   presentation timestamp, or -1 if there is no such frame */
+    int64_t frame_number_of_pts(int64_t pts) const;
+
+    /** Returns the index in presentation order of the first frame with a
+    *   presentation timestamp at or after `pts`, or -1 if there is none */
+    int64_t frame_number_after_pts(int64_t pts) const;
+
+    /** Returns the indices in presentation order of all keyframes */
+    std::vector<int64_t> keyframe_numbers(void) const;
+
+    /** Returns the index into `entries` of the last keyframe at or before the
+    *   given entry in decoding order, or -1 if there is none */
+    int32_t keyframe_before(int32_t entry) const;
+
+    /** Returns the default sidecar path of a video file, which is the path of
+    *   the video file with the extension ".mvidx" appended */
+    static std::string sidecar_path(const char *url);
+
+private:
+    /** Computes `presentation_order` and `keyframes` from `entries` */
+    void update_lookup_tables(void);
+};
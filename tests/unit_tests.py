@@ -1,10 +1,15 @@
 import os
+import tempfile
 import unittest
 import time
+import threading
 
 import numpy as np
 
-from mvextractor.videocap import VideoCap
+from mvextractor.videocap import VideoCap, build_index, mvs_pool_stats, mvs_pool_clear, empty_motion_vectors
+from mvextractor.videocap import MB_TYPE_INTRA_16X16, MB_TYPE_INTRA_NXN, MB_TYPE_INTRA_PCM, MB_TYPE_SKIP, \
+    MB_TYPE_DIRECT, MB_TYPE_INTER_16X16, MB_TYPE_INTER_16X8, MB_TYPE_INTER_8X16, MB_TYPE_INTER_8X8, MB_TYPE_UNKNOWN
+from mvextractor.parallel import ParallelVideoCap
 
 
 PROJECT_ROOT = os.getenv("PROJECT_ROOT", "")
@@ -50,6 +55,17 @@ class TestMotionVectorExtraction(unittest.TestCase):
         self.assertIn('read', dir(self.cap))
         self.assertIn('release', dir(self.cap))
         self.assertIn('retrieve', dir(self.cap))
+        self.assertIn('read_into', dir(self.cap))
+        self.assertIn('read_batch', dir(self.cap))
+        self.assertIn('read_mvs', dir(self.cap))
+        self.assertIn('stats', dir(self.cap))
+        self.assertIn('frame_number', dir(self.cap))
+        self.assertIn('seek', dir(self.cap))
+        self.assertIn('seek_time', dir(self.cap))
+        self.assertIn('frame_count', dir(self.cap))
+        self.assertIn('read_yuv', dir(self.cap))
+        self.assertIn('retrieve_yuv', dir(self.cap))
+        self.assertIn('keyframes', dir(self.cap))
 
 
     def test_open_video(self):
@@ -132,6 +148,424 @@ class TestMotionVectorExtraction(unittest.TestCase):
         [self.validate_motion_vectors(motion_vector, shape) for motion_vector, shape in zip(motion_vectors, shapes)]
 
 
+    def test_read_returns_independent_frames(self):
+        self.open_video()
+        _, frame1, _, _, _ = self.cap.read()
+        _, frame2, _, _, _ = self.cap.read()
+        self.assertTrue(frame1.flags["C_CONTIGUOUS"])
+        self.assertTrue(frame1.flags["OWNDATA"])
+        self.assertFalse(np.shares_memory(frame1, frame2))
+
+
+    def test_read_in_parallel_threads(self):
+        frame_types = {}
+
+        def read_frames(idx):
+            cap = VideoCap()
+            cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+            frame_types[idx] = [cap.read()[3] for _ in range(10)]
+            cap.release()
+
+        threads = [threading.Thread(target=read_frames, args=(idx,)) for idx in range(4)]
+        [thread.start() for thread in threads]
+        [thread.join() for thread in threads]
+        for idx in range(4):
+            self.assertEqual(frame_types[idx], ['I', 'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P'])
+
+
+    def test_read_into(self):
+        self.open_video()
+        cap_ref = VideoCap()
+        cap_ref.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        frame = np.zeros((720, 1280, 3), dtype=np.uint8)
+        motion_vectors = np.zeros((8192, 10), dtype=np.int32)
+        frame_buffer = frame.ctypes.data
+        for _ in range(10):
+            ret, num_mvs, frame_type, timestamp = self.cap.read_into(frame, motion_vectors)
+            ret_ref, frame_ref, motion_vectors_ref, frame_type_ref, _ = cap_ref.read()
+            self.assertTrue(ret)
+            self.assertEqual(ret, ret_ref)
+            self.assertEqual(frame_type, frame_type_ref)
+            self.validate_timestamp(timestamp)
+            self.assertEqual(num_mvs, motion_vectors_ref.shape[0])
+            self.assertTrue(np.all(motion_vectors[:num_mvs] == motion_vectors_ref))
+            self.assertTrue(np.all(frame == frame_ref))
+        self.assertEqual(frame.ctypes.data, frame_buffer)
+        cap_ref.release()
+
+
+    def test_read_into_too_few_motion_vectors(self):
+        self.open_video()
+        self.cap.read()  # skip first frame (I frame)
+        frame = np.zeros((720, 1280, 3), dtype=np.uint8)
+        motion_vectors = np.zeros((10, 10), dtype=np.int32)
+        ret, num_mvs, frame_type, _ = self.cap.read_into(frame, motion_vectors)
+        self.assertTrue(ret)
+        self.assertEqual(frame_type, "P")
+        self.assertEqual(num_mvs, 3665)
+        self.assertEqual(motion_vectors[0].tolist(), [-1, 16, 16, 8, 8, 8, 8, 0, 0, 4])
+
+
+    def test_read_into_wrong_frame_shape(self):
+        self.open_video()
+        frame = np.zeros((360, 640, 3), dtype=np.uint8)
+        motion_vectors = np.zeros((8192, 10), dtype=np.int32)
+        with self.assertRaises(ValueError):
+            self.cap.read_into(frame, motion_vectors)
+        # the frame is not lost and can be read into an array of the right shape
+        frame = np.zeros((720, 1280, 3), dtype=np.uint8)
+        ret, _, frame_type, _ = self.cap.read_into(frame, motion_vectors)
+        self.assertTrue(ret)
+        self.assertEqual(self.cap.frame_number(), 0)
+        self.assertEqual(frame_type, "I")
+
+
+    def test_read_batch(self):
+        self.open_video()
+        frames, motion_vectors, offsets, frame_types, timestamps = self.cap.read_batch(10)
+        self.assertEqual(frames.shape, (10, 720, 1280, 3))
+        self.assertEqual(frames.dtype, np.uint8)
+        self.validate_motion_vectors(motion_vectors, shape=(offsets[-1], 10))
+        self.assertEqual(offsets.shape, (11,))
+        self.assertEqual(np.diff(offsets).tolist(), [0, 3665, 3696, 3722, 3807, 3953, 4155, 3617, 4115, 4192])
+        self.assertEqual(frame_types.tolist(), [b'I', b'P', b'P', b'P', b'P', b'P', b'P', b'P', b'P', b'P'])
+        self.assertEqual(timestamps.shape, (10,))
+        [self.validate_timestamp(float(timestamp)) for timestamp in timestamps]
+
+        # batches continue where the previous read stopped
+        cap_ref = VideoCap()
+        cap_ref.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        for i in range(10):
+            _, frame_ref, motion_vectors_ref, _, _ = cap_ref.read()
+            self.assertTrue(np.all(frames[i] == frame_ref))
+            self.assertTrue(np.all(motion_vectors[offsets[i]:offsets[i+1]] == motion_vectors_ref))
+        cap_ref.release()
+
+
+    def test_read_batch_end_of_stream(self):
+        self.open_video()
+        num_frames = 0
+        while True:
+            frames, _, offsets, frame_types, timestamps = self.cap.read_batch(100)
+            self.assertEqual(len(frames), len(frame_types))
+            self.assertEqual(len(frames), len(timestamps))
+            self.assertEqual(len(frames) + 1, len(offsets))
+            # short batches own memory of their actual size instead of viewing a full batch
+            for array in (frames, offsets, frame_types, timestamps):
+                self.assertIsNone(array.base)
+            self.assertEqual(frames.nbytes, len(frames) * 720 * 1280 * 3)
+            if len(frames) == 0:
+                break
+            num_frames += len(frames)
+        self.assertEqual(num_frames, 337)
+
+
+    def test_read_without_frames(self):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False)
+        self.assertTrue(ret)
+        self.cap.read()  # skip first frame (I frame)
+        ret, frame, motion_vectors, frame_type, timestamp = self.cap.read()
+        self.assertTrue(ret)
+        self.assertIsNone(frame)
+        self.assertEqual(frame_type, "P")
+        self.validate_timestamp(timestamp)
+        self.validate_motion_vectors(motion_vectors, shape=(3665, 10))
+
+
+    def test_read_mvs(self):
+        self.open_video()
+        frame_types = []
+        shapes = []
+        for _ in range(3):
+            ret, motion_vectors, frame_type, timestamp = self.cap.read_mvs()
+            self.assertTrue(ret)
+            self.validate_timestamp(timestamp)
+            frame_types.append(frame_type)
+            shapes.append(motion_vectors.shape)
+        self.assertEqual(frame_types, ['I', 'P', 'P'])
+        self.assertEqual(shapes, [(0, 10), (3665, 10), (3696, 10)])
+
+
+    def test_read_batch_without_frames(self):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False)
+        frames, motion_vectors, offsets, frame_types, _ = self.cap.read_batch(3)
+        self.assertIsNone(frames)
+        self.assertEqual(offsets.tolist(), [0, 0, 3665, 3665 + 3696])
+        self.assertEqual(frame_types.tolist(), [b'I', b'P', b'P'])
+
+
+    def test_thread_options(self):
+        for thread_count, thread_type in [(1, "auto"), (2, "frame"), (4, "slice")]:
+            ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), thread_count=thread_count, thread_type=thread_type)
+            self.assertTrue(ret)
+            self.cap.read()  # skip first frame (I frame)
+            ret, frame, motion_vectors, frame_type, _ = self.cap.read()
+            self.assertTrue(ret)
+            self.validate_frame(frame)
+            self.validate_motion_vectors(motion_vectors, shape=(3665, 10))
+            self.assertEqual(frame_type, "P")
+
+
+    def test_frame_threading_drains_all_frames(self):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), thread_type="frame", thread_count=16)
+        self.assertTrue(ret)
+        num_frames = 0
+        while True:
+            ret, _, _, _ = self.cap.read_mvs()
+            if not ret:
+                break
+            num_frames += 1
+        # the frames buffered by the decoder threads are returned at the end of the stream
+        self.assertEqual(num_frames, 337)
+        self.assertFalse(self.cap.grab())
+
+
+    def test_invalid_thread_options(self):
+        with self.assertRaises(ValueError):
+            self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), thread_count=-1)
+        with self.assertRaises(ValueError):
+            self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), thread_type="invalid")
+
+
+    def test_invalid_open_arguments(self):
+        with self.assertRaises(TypeError):
+            self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), thread_count="x")
+        with self.assertRaises(TypeError):
+            self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), unknown_option=True)
+
+
+    def test_low_latency(self):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), low_latency=True)
+        self.assertTrue(ret)
+        frame_types = []
+        for _ in range(3):
+            ret, frame, _, frame_type, timestamp = self.cap.read()
+            self.assertTrue(ret)
+            self.validate_frame(frame)
+            self.validate_timestamp(timestamp)
+            frame_types.append(frame_type)
+        self.assertEqual(frame_types, ['I', 'P', 'P'])
+
+
+    def test_stats_without_rtcp(self):
+        self.open_video()
+        self.cap.read()
+        stats = self.cap.stats()
+        # latency is only measured for RTSP streams with RTCP sender reports
+        self.assertEqual(stats["latency_count"], 0)
+        self.assertEqual(stats["latency_mean"], 0.0)
+
+
+    def test_stream_info_cache(self):
+        with tempfile.TemporaryDirectory() as cache_dir:
+            results = []
+            for expected_cached in [False, True]:
+                ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), stream_info_cache=cache_dir)
+                self.assertTrue(ret)
+                stats = self.cap.stats()
+                self.assertEqual(stats["stream_info_cached"], expected_cached)
+                self.assertGreater(stats["open_time"], 0)
+                self.assertEqual(len(os.listdir(cache_dir)), 1)
+                results.append([self.cap.read() for _ in range(3)])
+            for (_, frame_a, mvs_a, type_a, _), (_, frame_b, mvs_b, type_b, _) in zip(*results):
+                self.assertTrue(np.all(frame_a == frame_b))
+                self.assertTrue(np.all(mvs_a == mvs_b))
+                self.assertEqual(type_a, type_b)
+
+
+    def test_keyframes_only(self):
+        self.open_video()
+        frame_types = []
+        while True:
+            ret, _, frame_type, _ = self.cap.read_mvs()
+            if not ret:
+                break
+            frame_types.append(frame_type)
+        num_keyframes = frame_types.count('I')
+
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), keyframes_only=True)
+        self.assertTrue(ret)
+        frame_count = 0
+        while True:
+            ret, frame, motion_vectors, frame_type, _ = self.cap.read()
+            if not ret:
+                break
+            self.validate_frame(frame)
+            self.validate_motion_vectors(motion_vectors)
+            self.assertEqual(frame_type, "I")
+            frame_count += 1
+        self.assertGreater(frame_count, 0)
+        self.assertEqual(frame_count, num_keyframes)
+
+
+    def test_frame_number(self):
+        self.open_video()
+        self.assertEqual(self.cap.frame_number(), -1)
+        for i in range(10):
+            self.cap.read()
+            self.assertEqual(self.cap.frame_number(), i)
+
+
+    def test_frame_metadata(self):
+        self.open_video()
+        self.assertIsNone(self.cap.frame_metadata())
+        positions = set()
+        pts = []
+        for i in range(30):
+            self.assertTrue(self.cap.grab())
+            metadata = self.cap.frame_metadata()
+            self.assertGreater(metadata["packet_size"], 0)
+            self.assertGreaterEqual(metadata["pos"], 0)
+            self.assertIsInstance(metadata["pts"], int)
+            self.assertIsInstance(metadata["dts"], int)
+            self.assertEqual(len(metadata["time_base"]), 2)
+            self.assertGreaterEqual(metadata["decode_time"], 0.0)
+            # only the first frame of the video is a keyframe
+            self.assertEqual(metadata["key_frame"], i == 0)
+            positions.add(metadata["pos"])
+            pts.append(metadata["pts"])
+            ret, _, _, frame_type, _ = self.cap.retrieve()
+            self.assertTrue(ret)
+            self.assertEqual(frame_type == "I", metadata["key_frame"])
+        # each frame is decoded from its own packet, frames are returned in presentation order
+        self.assertEqual(len(positions), 30)
+        self.assertEqual(pts, sorted(pts))
+
+
+    def test_pts_timestamps(self):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), timestamp_source="pts")
+        self.assertTrue(ret)
+        timestamps = []
+        for i in range(10):
+            ret, _, _, _, timestamp = self.cap.read()
+            self.assertTrue(ret)
+            self.assertIsInstance(timestamp, float)
+            metadata = self.cap.frame_metadata()
+            time_base = metadata["time_base"][0] / metadata["time_base"][1]
+            self.assertAlmostEqual(timestamp, metadata["pts"] * time_base)
+            timestamps.append(timestamp)
+        # timestamps start at zero and advance by one frame duration, regardless of reading speed
+        self.assertAlmostEqual(timestamps[0], 0.0)
+        frame_durations = np.diff(timestamps)
+        self.assertTrue(np.all(frame_durations > 0))
+        self.assertTrue(np.allclose(frame_durations, frame_durations[0]))
+
+
+    def test_creation_time_timestamps(self):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), timestamp_source="pts")
+        self.assertTrue(ret)
+        pts_timestamps = [self.cap.read()[4] for _ in range(10)]
+        # the creation time of the test video is the UNIX epoch, so both sources match
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), timestamp_source="creation_time")
+        self.assertTrue(ret)
+        creation_timestamps = [self.cap.read()[4] for _ in range(10)]
+        self.assertEqual(pts_timestamps, creation_timestamps)
+        # without creation time the presentation time is returned
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_mpeg4_part2.mp4"), timestamp_source="creation_time")
+        self.assertTrue(ret)
+        self.assertAlmostEqual(self.cap.read()[4], 0.0)
+        self.cap.release()
+        # set the creation time in the movie header of a copy of the video, the
+        # field counts seconds since 1904-01-01 and follows version and flags
+        creation_time = 1600000000
+        with open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), "rb") as f:
+            data = bytearray(f.read())
+        mvhd = data.find(b"mvhd")
+        self.assertEqual(data[mvhd + 4], 0)  # version 0 stores 32 bit times
+        data[mvhd + 8:mvhd + 12] = (creation_time + 2082844800).to_bytes(4, "big")
+        with tempfile.TemporaryDirectory() as tmpdir:
+            video_path = os.path.join(tmpdir, "vid_h264.mp4")
+            with open(video_path, "wb") as f:
+                f.write(data)
+            ret = self.cap.open(video_path, timestamp_source="creation_time")
+            self.assertTrue(ret)
+            creation_timestamps = [self.cap.read()[4] for _ in range(10)]
+            self.cap.release()
+        for pts_timestamp, creation_timestamp in zip(pts_timestamps, creation_timestamps):
+            self.assertAlmostEqual(creation_timestamp, pts_timestamp + creation_time)
+
+
+    def test_invalid_timestamp_source(self):
+        with self.assertRaises(ValueError):
+            self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), timestamp_source="invalid")
+
+
+    def test_skip_nonref(self):
+        def read_frames(video, **kwargs):
+            ret = self.cap.open(os.path.join(PROJECT_ROOT, video), **kwargs)
+            self.assertTrue(ret)
+            frames = []
+            while True:
+                ret, frame, _, frame_type, timestamp = self.cap.read()
+                if not ret:
+                    break
+                self.validate_frame(frame)
+                self.validate_timestamp(timestamp)
+                frames.append((self.cap.frame_number(), frame_type, self.cap.frame_metadata()["pts"]))
+            self.cap.release()
+            return frames
+
+        # the B frames of vid_h264_bframes.mp4 (IBBP, 60 frames) are not used as
+        # reference, vid_h264.mp4 has only I and P frames, so nothing is skipped
+        for video, num_frames, num_ref_frames in [("vid_h264_bframes.mp4", 60, 22), ("vid_h264.mp4", 337, 337)]:
+            all_frames = read_frames(video)
+            self.assertEqual([frame_number for frame_number, _, _ in all_frames], list(range(num_frames)))
+            frames = read_frames(video, skip_nonref=True)
+            self.assertEqual(len(frames), num_ref_frames)
+            self.assertTrue(all(frame_type in ["I", "P"] for _, frame_type, _ in frames))
+            # returned frames keep their frame number and pts despite the gaps
+            self.assertEqual(frames, [frame for frame in all_frames if frame[1] != "B"])
+
+
+    def test_seek(self):
+        self.open_video()
+        frames = []
+        for _ in range(120):
+            ret, frame, motion_vectors, frame_type, _ = self.cap.read()
+            frames.append((frame, motion_vectors, frame_type))
+
+        for frame_index in [100, 5, 0, 119]:
+            ret = self.cap.seek(frame_index)
+            self.assertTrue(ret)
+            ret, frame, motion_vectors, frame_type, _ = self.cap.read()
+            self.assertTrue(ret)
+            self.assertEqual(self.cap.frame_number(), frame_index)
+            self.assertTrue(np.all(frame == frames[frame_index][0]))
+            self.assertTrue(np.all(motion_vectors == frames[frame_index][1]))
+            self.assertEqual(frame_type, frames[frame_index][2])
+
+        # reading continues after the frame seeked to
+        self.cap.read()
+        self.assertEqual(self.cap.frame_number(), 120)
+
+
+    def test_seek_time(self):
+        self.open_video()
+        ret = self.cap.seek_time(2.0)
+        self.assertTrue(ret)
+        ret, frame, _, _, _ = self.cap.read()
+        self.assertTrue(ret)
+        self.validate_frame(frame)
+        frame_number = self.cap.frame_number()
+        self.assertGreater(frame_number, 0)
+
+        ret = self.cap.seek(frame_number)
+        self.assertTrue(ret)
+        ret, frame_seek, _, _, _ = self.cap.read()
+        self.assertTrue(np.all(frame == frame_seek))
+
+
+    def test_seek_beyond_end(self):
+        self.open_video()
+        self.assertFalse(self.cap.seek(100000))
+        self.assertFalse(self.cap.seek_time(100000.0))
+        # the video can still be read from the start after a failed seek
+        self.assertTrue(self.cap.seek(0))
+        ret, _, _, frame_type, _ = self.cap.read()
+        self.assertTrue(ret)
+        self.assertEqual(frame_type, "I")
+
+
     def test_frame_count(self):
         self.open_video()
         frame_count = 0
@@ -163,6 +597,741 @@ class TestMotionVectorExtraction(unittest.TestCase):
         self.assertLess(dt_std, 0.003, msg=f"Standard deviation of frame read duration exceeds maximum ({dt_std} s > {0.003} s)")
 
 
+class TestDecodeProfiles(unittest.TestCase):
+
+    def read_all_mvs(self, decode_profile):
+        cap = VideoCap()
+        cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False, decode_profile=decode_profile)
+        results = []
+        times = []
+        while True:
+            tstart = time.perf_counter()
+            ret, motion_vectors, frame_type, _ = cap.read_mvs()
+            times.append(time.perf_counter() - tstart)
+            if not ret:
+                break
+            results.append((frame_type, motion_vectors))
+        cap.release()
+        return results, np.mean(times)
+
+
+    def test_invalid_decode_profile(self):
+        cap = VideoCap()
+        with self.assertRaises(ValueError):
+            cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), decode_profile="invalid")
+
+
+    def test_mvs_profile_exact_motion_vectors(self):
+        results_full, _ = self.read_all_mvs("full")
+        results_mvs, _ = self.read_all_mvs("mvs")
+        self.assertEqual(len(results_full), len(results_mvs))
+        for (frame_type_full, mvs_full), (frame_type_mvs, mvs_mvs) in zip(results_full, results_mvs):
+            self.assertEqual(frame_type_full, frame_type_mvs)
+            self.assertTrue(np.all(mvs_full == mvs_mvs))
+
+
+    def test_mvs_profile_timings(self):
+        _, dt_mean_full = self.read_all_mvs("full")
+        _, dt_mean_mvs = self.read_all_mvs("mvs")
+        # not asserted, for H.264 only the loop filter is skipped, which is too
+        # small a difference to measure reliably on shared machines
+        print(f"Timings: full profile {dt_mean_full} s -- mvs profile {dt_mean_mvs} s")
+
+
+class TestMotionVectorLayout(unittest.TestCase):
+
+    def setUp(self):
+        self.cap = VideoCap()
+        self.cap_soa = VideoCap()
+        video = os.path.join(PROJECT_ROOT, "vid_h264.mp4")
+        self.assertTrue(self.cap.open(video, frames=False))
+        self.assertTrue(self.cap_soa.open(video, frames=False, mvs_layout="soa"))
+
+
+    def tearDown(self):
+        self.cap.release()
+        self.cap_soa.release()
+
+
+    def test_soa_is_transposed_aos(self):
+        for _ in range(20):
+            ret, _, motion_vectors, _, _ = self.cap.read()
+            ret_soa, _, motion_vectors_soa, _, _ = self.cap_soa.read()
+            self.assertEqual(ret, ret_soa)
+            self.assertEqual(motion_vectors_soa.shape, (10, motion_vectors.shape[0]))
+            self.assertTrue(motion_vectors_soa.flags.c_contiguous)
+            self.assertTrue(np.all(motion_vectors_soa == motion_vectors.T))
+
+
+    def test_soa_read_into(self):
+        self.cap.read()
+        self.cap_soa.read()
+        motion_vectors = np.zeros((10000, 10), dtype=np.int32)
+        motion_vectors_soa = np.zeros((10, 10000), dtype=np.int32)
+        _, num_mvs, _, _ = self.cap.read_into(None, motion_vectors)
+        _, num_mvs_soa, _, _ = self.cap_soa.read_into(None, motion_vectors_soa)
+        self.assertEqual(num_mvs, num_mvs_soa)
+        self.assertGreater(num_mvs, 0)
+        self.assertTrue(np.all(motion_vectors_soa[:, :num_mvs] == motion_vectors[:num_mvs].T))
+        with self.assertRaises(ValueError):
+            self.cap_soa.read_into(None, motion_vectors)
+
+
+    def test_soa_read_batch(self):
+        _, motion_vectors, offsets, _, _ = self.cap.read_batch(10)
+        _, motion_vectors_soa, offsets_soa, _, _ = self.cap_soa.read_batch(10)
+        self.assertTrue(np.all(offsets == offsets_soa))
+        self.assertEqual(motion_vectors_soa.shape, (10, offsets[-1]))
+        self.assertTrue(np.all(motion_vectors_soa == motion_vectors.T))
+
+
+    def test_invalid_mvs_layout(self):
+        with self.assertRaises(ValueError):
+            self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), mvs_layout="invalid")
+
+
+class TestMotionVectorDtype(unittest.TestCase):
+
+    def setUp(self):
+        self.cap = VideoCap()
+
+
+    def tearDown(self):
+        self.cap.release()
+
+
+    def read_motion_vectors(self, num_frames, **kwargs):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False, **kwargs))
+        motion_vectors = []
+        for _ in range(num_frames):
+            ret, _, mvs, _, _ = self.cap.read()
+            self.assertTrue(ret)
+            motion_vectors.append(mvs)
+        return motion_vectors
+
+
+    def test_int16(self):
+        motion_vectors = self.read_motion_vectors(20)
+        motion_vectors_int16 = self.read_motion_vectors(20, mvs_dtype="int16")
+        for mvs, mvs_int16 in zip(motion_vectors, motion_vectors_int16):
+            self.assertEqual(mvs_int16.dtype, np.int16)
+            self.assertEqual(mvs_int16.shape, mvs.shape)
+            self.assertTrue(np.all(mvs_int16 == mvs))
+
+
+    def test_int16_soa(self):
+        motion_vectors = self.read_motion_vectors(20)
+        motion_vectors_int16 = self.read_motion_vectors(20, mvs_dtype="int16", mvs_layout="soa")
+        for mvs, mvs_int16 in zip(motion_vectors, motion_vectors_int16):
+            self.assertEqual(mvs_int16.dtype, np.int16)
+            self.assertTrue(np.all(mvs_int16 == mvs.T))
+
+
+    def test_packed(self):
+        fields = ["source", "w", "h", "src_x", "src_y", "dst_x", "dst_y", "motion_x", "motion_y", "motion_scale"]
+        motion_vectors = self.read_motion_vectors(20)
+        motion_vectors_packed = self.read_motion_vectors(20, mvs_dtype="packed")
+        for mvs, mvs_packed in zip(motion_vectors, motion_vectors_packed):
+            self.assertEqual(mvs_packed.dtype.names, tuple(fields))
+            self.assertEqual(mvs_packed.dtype.itemsize, 16)
+            self.assertEqual(mvs_packed.shape, (mvs.shape[0],))
+            for i, field in enumerate(fields):
+                self.assertTrue(np.all(mvs_packed[field] == mvs[:, i]))
+
+
+    def test_packed_read_into_and_read_batch(self):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False, mvs_dtype="packed")
+        _, _, motion_vectors, _, _ = self.cap.read()
+        mvs_out = np.zeros((10000,), dtype=motion_vectors.dtype)
+        ret, num_mvs, _, _ = self.cap.read_into(None, mvs_out)
+        self.assertTrue(ret)
+        self.assertGreater(num_mvs, 0)
+        self.assertTrue(np.all(mvs_out["w"][:num_mvs] > 0))
+        with self.assertRaises(ValueError):
+            self.cap.read_into(None, np.zeros((10000, 10), dtype=np.int32))
+        _, motion_vectors, offsets, _, _ = self.cap.read_batch(5)
+        self.assertEqual(motion_vectors.shape, (offsets[-1],))
+        self.assertEqual(motion_vectors.dtype, mvs_out.dtype)
+
+
+    def test_empty_motion_vectors(self):
+        for kwargs in [{}, {"mvs_layout": "soa"}, {"mvs_dtype": "int16"}, {"mvs_dtype": "packed"}]:
+            motion_vectors = self.read_motion_vectors(1, **kwargs)[0]
+            empty = empty_motion_vectors(**kwargs)
+            self.assertEqual(empty.dtype, motion_vectors.dtype)
+            self.assertEqual(empty.ndim, motion_vectors.ndim)
+            self.assertEqual(empty.size, 0)
+        self.assertEqual(empty_motion_vectors().shape, (0, 10))
+        self.assertEqual(empty_motion_vectors(mvs_layout="soa").shape, (10, 0))
+        with self.assertRaises(ValueError):
+            empty_motion_vectors(mvs_dtype="packed", mvs_layout="soa")
+
+
+    def test_invalid_mvs_dtype(self):
+        video = os.path.join(PROJECT_ROOT, "vid_h264.mp4")
+        with self.assertRaises(ValueError):
+            self.cap.open(video, mvs_dtype="invalid")
+        with self.assertRaises(ValueError):
+            self.cap.open(video, mvs_dtype="packed", mvs_layout="soa")
+
+
+class TestMotionVectorPool(unittest.TestCase):
+
+    def setUp(self):
+        self.cap = VideoCap()
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False))
+
+
+    def tearDown(self):
+        self.cap.release()
+
+
+    def test_buffers_are_reused(self):
+        mvs_pool_clear()
+        stats_before = mvs_pool_stats()
+        for _ in range(50):
+            self.cap.read()
+        stats = mvs_pool_stats()
+        misses = stats["misses"] - stats_before["misses"]
+        hits = stats["hits"] - stats_before["hits"]
+        # the arrays are released right away, so only the first frames of each size allocate
+        self.assertGreater(hits, 0)
+        self.assertLess(misses, 10)
+        self.assertGreater(stats["cached_buffers"], 0)
+
+
+    def test_buffers_stay_valid(self):
+        motion_vectors = []
+        copies = []
+        for _ in range(30):
+            _, _, mvs, _, _ = self.cap.read()
+            motion_vectors.append(mvs)
+            copies.append(mvs.copy())
+        # buffers of arrays which are still alive are never handed out again
+        for mvs, mvs_copy in zip(motion_vectors, copies):
+            self.assertTrue(np.all(mvs == mvs_copy))
+
+
+    def test_clear(self):
+        for _ in range(5):
+            self.cap.read()
+        mvs_pool_clear()
+        stats = mvs_pool_stats()
+        self.assertEqual(stats["cached_buffers"], 0)
+        self.assertEqual(stats["cached_bytes"], 0)
+
+
+class TestQuantizationParameters(unittest.TestCase):
+
+    def setUp(self):
+        self.cap = VideoCap()
+
+
+    def tearDown(self):
+        self.cap.release()
+
+
+    def validate_qp(self, qp, max_qp):
+        self.assertEqual(type(qp), np.ndarray)
+        self.assertEqual(qp.dtype, np.int8)
+        self.assertEqual(qp.shape, (45, 80))
+        self.assertGreaterEqual(qp.min(), 0)
+        self.assertLessEqual(qp.max(), max_qp)
+
+
+    def test_qp_before_grab(self):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4")))
+        self.assertIsNone(self.cap.retrieve_qp())
+
+
+    def test_qp_h264(self):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4")))
+        for _ in range(10):
+            self.assertTrue(self.cap.grab())
+            qp = self.cap.retrieve_qp()
+            self.validate_qp(qp, 51)
+
+
+    def test_qp_mpeg4_part2(self):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_mpeg4_part2.mp4")))
+        for _ in range(10):
+            ret, _, _, _, _ = self.cap.read()
+            self.assertTrue(ret)
+            qp = self.cap.retrieve_qp()
+            self.validate_qp(qp, 31)
+            self.assertGreaterEqual(qp.min(), 1)
+
+
+    def test_qp_is_a_copy(self):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False))
+        self.assertTrue(self.cap.grab())
+        qp = self.cap.retrieve_qp()
+        qp_copy = qp.copy()
+        for _ in range(5):
+            self.cap.read()
+        self.assertTrue(np.all(qp == qp_copy))
+
+
+class TestMacroblockTypes(unittest.TestCase):
+
+    INTRA_TYPES = [MB_TYPE_INTRA_16X16, MB_TYPE_INTRA_NXN, MB_TYPE_INTRA_PCM]
+    ALL_TYPES = INTRA_TYPES + [MB_TYPE_SKIP, MB_TYPE_DIRECT, MB_TYPE_INTER_16X16, MB_TYPE_INTER_16X8,
+        MB_TYPE_INTER_8X16, MB_TYPE_INTER_8X8, MB_TYPE_UNKNOWN]
+
+    def setUp(self):
+        self.cap = VideoCap()
+
+
+    def tearDown(self):
+        self.cap.release()
+
+
+    def validate_mb_types(self, mb_types):
+        self.assertEqual(type(mb_types), np.ndarray)
+        self.assertEqual(mb_types.dtype, np.uint8)
+        self.assertEqual(mb_types.shape, (45, 80))
+        self.assertTrue(np.all(np.isin(mb_types, self.ALL_TYPES)))
+
+
+    def test_mb_types_before_grab(self):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4")))
+        self.assertIsNone(self.cap.retrieve_mb_types())
+
+
+    def check_mb_types(self, video):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, video), frames=False))
+        for _ in range(30):
+            self.assertTrue(self.cap.grab())
+            mb_types = self.cap.retrieve_mb_types()
+            self.validate_mb_types(mb_types)
+            ret, motion_vectors, frame_type, _ = self.cap.read_mvs()
+            self.assertTrue(ret)
+            if frame_type == "I":
+                # keyframes only contain intra macroblocks
+                mb_types = self.cap.retrieve_mb_types()
+                self.assertTrue(np.all(np.isin(mb_types, self.INTRA_TYPES)))
+
+
+    def test_mb_types_h264(self):
+        self.check_mb_types("vid_h264.mp4")
+
+
+    def test_mb_types_mpeg4_part2(self):
+        self.check_mb_types("vid_mpeg4_part2.mp4")
+
+
+    def test_mb_types_match_motion_vectors(self):
+        self.assertTrue(self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False))
+        for _ in range(30):
+            ret, motion_vectors, frame_type, _ = self.cap.read_mvs()
+            self.assertTrue(ret)
+            if frame_type != "P":
+                continue
+            mb_types = self.cap.retrieve_mb_types()
+            # intra macroblocks of P frames have no motion vectors
+            mb_x = motion_vectors[:, 5] // 16
+            mb_y = motion_vectors[:, 6] // 16
+            self.assertFalse(np.any(np.isin(mb_types[mb_y, mb_x], self.INTRA_TYPES)))
+
+
+class TestOutputFormat(unittest.TestCase):
+
+    def setUp(self):
+        self.cap = VideoCap()
+
+
+    def tearDown(self):
+        self.cap.release()
+
+
+    def read_frame(self, **kwargs):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), **kwargs)
+        self.assertTrue(ret)
+        ret, frame, _, _, _ = self.cap.read()
+        self.assertTrue(ret)
+        self.assertEqual(frame.dtype, np.uint8)
+        return frame
+
+
+    def test_output_formats(self):
+        self.assertEqual(self.read_frame(output_format="bgr24").shape, (720, 1280, 3))
+        self.assertEqual(self.read_frame(output_format="rgb24").shape, (720, 1280, 3))
+        self.assertEqual(self.read_frame(output_format="gray").shape, (720, 1280))
+        self.assertEqual(self.read_frame(output_format="nv12").shape, (1080, 1280))
+        self.assertEqual(self.read_frame(output_format="yuv420p").shape, (1080, 1280))
+
+
+    def test_rgb_is_reversed_bgr(self):
+        frame_bgr = self.read_frame(output_format="bgr24")
+        frame_rgb = self.read_frame(output_format="rgb24")
+        self.assertTrue(np.all(frame_bgr[:, :, ::-1] == frame_rgb))
+
+
+    def test_luma_planes_equal_gray(self):
+        frame_gray = self.read_frame(output_format="gray", scaler="point")
+        frame_nv12 = self.read_frame(output_format="nv12", scaler="point")
+        frame_yuv420p = self.read_frame(output_format="yuv420p", scaler="point")
+        self.assertTrue(np.all(frame_nv12[:720] == frame_gray))
+        self.assertTrue(np.all(frame_yuv420p[:720] == frame_gray))
+
+
+    def test_output_size(self):
+        self.assertEqual(self.read_frame(output_width=640, output_height=360).shape, (360, 640, 3))
+        self.assertEqual(self.read_frame(output_width=640).shape, (360, 640, 3))
+        self.assertEqual(self.read_frame(output_height=360, output_format="gray", scaler="fast_bilinear").shape, (360, 640))
+        self.assertEqual(self.read_frame(output_width=321, output_height=181, output_format="nv12").shape, (273, 322))
+
+
+    def test_read_into_and_read_batch(self):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), output_format="gray", output_width=640, output_height=360)
+        frame_out = np.zeros((360, 640), dtype=np.uint8)
+        mvs_out = np.zeros((10000, 10), dtype=np.int32)
+        ret, _, _, _ = self.cap.read_into(frame_out, mvs_out)
+        self.assertTrue(ret)
+        self.assertGreater(frame_out.sum(), 0)
+        with self.assertRaises(ValueError):
+            self.cap.read_into(np.zeros((360, 640, 3), dtype=np.uint8), mvs_out)
+        frames, _, _, _, _ = self.cap.read_batch(3)
+        self.assertEqual(frames.shape, (3, 360, 640))
+        # empty batches have the same number of dimensions
+        frames, _, _, _, _ = self.cap.read_batch(0)
+        self.assertEqual(frames.shape, (0, 0, 0))
+
+
+    def test_read_yuv(self):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        ret, planes, motion_vectors, frame_type, _ = self.cap.read_yuv()
+        self.assertTrue(ret)
+        self.assertEqual(frame_type, "I")
+        self.assertEqual(motion_vectors.shape, (0, 10))
+        self.assertEqual([plane.shape for plane in planes], [(720, 1280), (360, 640), (360, 640)])
+        for plane in planes:
+            self.assertEqual(plane.dtype, np.uint8)
+            self.assertFalse(plane.flags.writeable)
+        with self.assertRaises(ValueError):
+            planes[0][0, 0] = 0
+
+
+    def test_yuv_planes_stay_valid(self):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        planes_yuv = []
+        planes_copies = []
+        for _ in range(10):
+            _, planes, _, _, _ = self.cap.read_yuv()
+            planes_yuv.append(planes)
+            planes_copies.append([plane.copy() for plane in planes])
+        # planes of earlier frames are not overwritten by later frames
+        for planes, copies in zip(planes_yuv, planes_copies):
+            for plane, copy in zip(planes, copies):
+                self.assertTrue(np.all(plane == copy))
+
+
+    def test_read_yuv_end_of_stream(self):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        self.cap.seek(336)
+        self.cap.read_yuv()
+        ret, planes, _, _, _ = self.cap.read_yuv()
+        self.assertFalse(ret)
+        self.assertIsNone(planes)
+
+
+    def test_invalid_output_options(self):
+        video = os.path.join(PROJECT_ROOT, "vid_h264.mp4")
+        with self.assertRaises(ValueError):
+            self.cap.open(video, output_format="invalid")
+        with self.assertRaises(ValueError):
+            self.cap.open(video, scaler="invalid")
+        with self.assertRaises(ValueError):
+            self.cap.open(video, output_width=-1)
+        with self.assertRaises(ValueError):
+            self.cap.open(video, scale_threads=-1)
+
+
+    def read_frames(self, num_frames, **kwargs):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), **kwargs)
+        frames = []
+        for _ in range(num_frames):
+            ret, frame, _, _, _ = self.cap.read()
+            self.assertTrue(ret)
+            frames.append(frame)
+        return frames
+
+
+    def test_scale_threads(self):
+        for output_format in ["bgr24", "gray", "nv12", "yuv420p"]:
+            frames = self.read_frames(5, output_format=output_format, scaler="point")
+            for scale_threads in [0, 2, 3, 8]:
+                frames_sliced = self.read_frames(5, output_format=output_format, scaler="point", scale_threads=scale_threads)
+                for frame, frame_sliced in zip(frames, frames_sliced):
+                    self.assertTrue(np.all(frame == frame_sliced))
+
+
+    def test_scale_threads_unscaled_bgr_is_exact(self):
+        # the default conversion is not scaled, so slices match the whole frame exactly
+        frames = self.read_frames(5)
+        frames_sliced = self.read_frames(5, scale_threads=4)
+        for frame, frame_sliced in zip(frames, frames_sliced):
+            self.assertTrue(np.all(frame == frame_sliced))
+
+
+    def test_scale_threads_with_vertical_scaling(self):
+        # vertically scaled frames are not sliced
+        frames = self.read_frames(5, output_width=640, output_height=360)
+        frames_sliced = self.read_frames(5, output_width=640, output_height=360, scale_threads=4)
+        for frame, frame_sliced in zip(frames, frames_sliced):
+            self.assertTrue(np.all(frame == frame_sliced))
+
+
+    def retrieve_time(self, scale_threads):
+        self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), scale_threads=scale_threads)
+        times = []
+        while self.cap.grab():
+            tstart = time.perf_counter()
+            ret, _, _, _, _ = self.cap.retrieve()
+            times.append(time.perf_counter() - tstart)
+            self.assertTrue(ret)
+        return np.mean(times)
+
+
+    def test_scale_threads_timings(self):
+        # benchmark of the color conversion, not an assertion on speed
+        timings = []
+        for scale_threads in [1, 2, 4, 8]:
+            timings.append(f"{scale_threads} threads {self.retrieve_time(scale_threads)} s")
+        print(f"Timings of retrieve: {' -- '.join(timings)}")
+
+
+class TestVideoIndex(unittest.TestCase):
+
+    def setUp(self):
+        self.cap = VideoCap()
+        self.tmp_dir = tempfile.TemporaryDirectory()
+
+
+    def tearDown(self):
+        self.cap.release()
+        self.tmp_dir.cleanup()
+
+
+    def index_path(self, video):
+        return os.path.join(self.tmp_dir.name, video + ".mvidx")
+
+
+    def read_all_frames(self, video):
+        self.cap.open(os.path.join(PROJECT_ROOT, video))
+        frames = []
+        while True:
+            ret, frame, motion_vectors, frame_type, _ = self.cap.read()
+            if not ret:
+                break
+            frames.append((frame, motion_vectors, frame_type))
+        return frames
+
+
+    def test_build_index(self):
+        for video in ["vid_h264.mp4", "vid_h264.264"]:
+            ret = build_index(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+            self.assertTrue(ret)
+            self.assertTrue(os.path.isfile(self.index_path(video)))
+
+
+    def test_build_index_invalid_video(self):
+        ret = build_index(os.path.join(PROJECT_ROOT, "vid_not_existent.mp4"), index_path=self.index_path("vid_not_existent.mp4"))
+        self.assertFalse(ret)
+
+
+    def test_frame_count(self):
+        for video in ["vid_h264.mp4", "vid_h264.264"]:
+            build_index(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+            ret = self.cap.open(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+            self.assertTrue(ret)
+            self.assertEqual(self.cap.frame_count(), 337)
+            keyframes = self.cap.keyframes()
+            self.assertEqual(keyframes.dtype, np.int64)
+            self.assertGreater(len(keyframes), 0)
+            self.assertEqual(keyframes[0], 0)
+
+
+    def test_no_index(self):
+        ret = self.cap.open(os.path.join(PROJECT_ROOT, "vid_h264.264"), index_path=self.index_path("vid_h264.264"))
+        self.assertTrue(ret)
+        self.assertEqual(len(self.cap.keyframes()), 0)
+
+
+    def test_corrupt_index(self):
+        video = "vid_h264.mp4"
+        build_index(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+        with open(self.index_path(video), "rb") as f:
+            data = bytearray(f.read())
+        # a huge number of entries in the header (at byte 48) and a truncated index
+        huge_num_entries = data[:48] + (2**62).to_bytes(8, "little") + data[56:]
+        for corrupt_data in [huge_num_entries, data[:-1]]:
+            with open(self.index_path(video), "wb") as f:
+                f.write(corrupt_data)
+            # the invalid index is ignored
+            ret = self.cap.open(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+            self.assertTrue(ret)
+            self.assertEqual(len(self.cap.keyframes()), 0)
+            self.cap.release()
+
+
+    def test_seek_with_index(self):
+        for video in ["vid_h264.mp4", "vid_h264.264"]:
+            frames = self.read_all_frames(video)
+            build_index(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+            self.cap.open(os.path.join(PROJECT_ROOT, video), index_path=self.index_path(video))
+            for frame_index in [200, 13, 0, 336]:
+                ret = self.cap.seek(frame_index)
+                self.assertTrue(ret)
+                ret, frame, motion_vectors, frame_type, _ = self.cap.read()
+                self.assertTrue(ret)
+                self.assertEqual(self.cap.frame_number(), frame_index)
+                self.assertTrue(np.all(frame == frames[frame_index][0]))
+                self.assertTrue(np.all(motion_vectors == frames[frame_index][1]))
+                self.assertEqual(frame_type, frames[frame_index][2])
+            self.assertFalse(self.cap.seek(337))
+
+
+class TestParallelVideoCap(unittest.TestCase):
+
+    def read_sequential(self, video="vid_h264.mp4", **kwargs):
+        cap = VideoCap()
+        cap.open(os.path.join(PROJECT_ROOT, video), **kwargs)
+        results = []
+        while True:
+            ret, frame, motion_vectors, frame_type, timestamp = cap.read()
+            if not ret:
+                break
+            results.append((frame, motion_vectors, frame_type, timestamp))
+        cap.release()
+        return results
+
+
+    def read_parallel(self, cap):
+        results = []
+        frame_numbers = []
+        while True:
+            ret, frame, motion_vectors, frame_type, timestamp = cap.read()
+            if not ret:
+                break
+            results.append((frame, motion_vectors, frame_type, timestamp))
+            frame_numbers.append(cap.frame_number())
+        return results, frame_numbers
+
+
+    def assert_same_results(self, results_a, results_b):
+        self.assertEqual(len(results_a), len(results_b))
+        for (frame_a, mvs_a, type_a, timestamp_a), (frame_b, mvs_b, type_b, timestamp_b) in zip(results_a, results_b):
+            if frame_a is None:
+                self.assertIsNone(frame_b)
+            else:
+                self.assertTrue(np.all(frame_a == frame_b))
+            self.assertEqual(mvs_a.dtype, mvs_b.dtype)
+            self.assertEqual(mvs_a.shape, mvs_b.shape)
+            self.assertTrue(np.all(mvs_a == mvs_b))
+            self.assertEqual(type_a, type_b)
+            self.assertEqual(timestamp_a, timestamp_b)
+
+
+    def test_parallel_equals_sequential(self):
+        results_sequential = self.read_sequential(timestamp_source="pts")
+        cap = ParallelVideoCap(num_workers=4, shard_frames=1)
+        ret = cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        self.assertTrue(ret)
+        results_parallel, frame_numbers = self.read_parallel(cap)
+        cap.release()
+        self.assert_same_results(results_sequential, results_parallel)
+        self.assertEqual(frame_numbers, list(range(337)))
+
+
+    def test_parallel_many_gops(self):
+        # the MPEG-4 Part 2 video has 30 GOPs of mostly 12 frames, but also GOPs of 6 frames and a single frame
+        results_sequential = self.read_sequential("vid_mpeg4_part2.mp4", timestamp_source="pts")
+        for num_workers, shard_frames, max_pending_shards in [(4, 1, None), (3, 20, None), (8, 1, 2), (2, 100, 1)]:
+            cap = ParallelVideoCap(num_workers=num_workers, shard_frames=shard_frames, max_pending_shards=max_pending_shards)
+            ret = cap.open(os.path.join(PROJECT_ROOT, "vid_mpeg4_part2.mp4"))
+            self.assertTrue(ret)
+            results_parallel, frame_numbers = self.read_parallel(cap)
+            cap.release()
+            self.assert_same_results(results_sequential, results_parallel)
+            self.assertEqual(frame_numbers, list(range(337)))
+
+
+    def test_parallel_without_frames(self):
+        results_sequential = self.read_sequential(frames=False, timestamp_source="pts")
+        cap = ParallelVideoCap(num_workers=2, shard_frames=1, max_pending_shards=1)
+        ret = cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False)
+        self.assertTrue(ret)
+        results_parallel, _ = self.read_parallel(cap)
+        cap.release()
+        self.assert_same_results(results_sequential, results_parallel)
+
+
+    def test_parallel_timestamps(self):
+        cap = ParallelVideoCap(num_workers=4, shard_frames=1)
+        cap.open(os.path.join(PROJECT_ROOT, "vid_mpeg4_part2.mp4"))
+        timestamps = [timestamp for _, _, _, timestamp in cap]
+        cap.release()
+        # presentation times do not depend on which worker decoded a frame
+        self.assertAlmostEqual(timestamps[0], 0.0)
+        self.assertTrue(np.all(np.diff(timestamps) > 0))
+
+
+    def test_parallel_max_pending_shards(self):
+        cap = ParallelVideoCap(num_workers=4)
+        self.assertEqual(cap.max_pending_shards, 5)
+        cap = ParallelVideoCap(num_workers=4, max_pending_shards=2)
+        self.assertEqual(cap.max_pending_shards, 2)
+
+
+    def test_parallel_end_of_stream_motion_vectors(self):
+        for kwargs, dtype, shape in [({}, np.int32, (0, 10)), ({"mvs_layout": "soa"}, np.int32, (10, 0)),
+                                     ({"mvs_dtype": "int16"}, np.int16, (0, 10)), ({"mvs_dtype": "packed"}, None, (0,))]:
+            cap = ParallelVideoCap(num_workers=2)
+            self.assertTrue(cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), frames=False, **kwargs))
+            for _ in cap:
+                pass
+            ret, _, motion_vectors, _, _ = cap.read()
+            cap.release()
+            self.assertFalse(ret)
+            self.assertEqual(motion_vectors.shape, shape)
+            if dtype is None:
+                self.assertIsNotNone(motion_vectors.dtype.names)
+            else:
+                self.assertEqual(motion_vectors.dtype, dtype)
+
+
+    def test_parallel_stale_index(self):
+        results_sequential = self.read_sequential(timestamp_source="pts")
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            # an index of another video is stale, as is the index of a modified video
+            index_path = os.path.join(tmp_dir, "vid_h264.mp4.mvidx")
+            self.assertTrue(build_index(os.path.join(PROJECT_ROOT, "vid_h264.264"), index_path=index_path))
+            cap = ParallelVideoCap(num_workers=4, shard_frames=1)
+            ret = cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"), index_path=index_path)
+            self.assertTrue(ret)
+            results_parallel, frame_numbers = self.read_parallel(cap)
+            cap.release()
+        self.assertEqual(frame_numbers, list(range(337)))
+        self.assert_same_results(results_parallel, results_sequential)
+
+
+    def test_parallel_iterator(self):
+        cap = ParallelVideoCap(num_workers=2)
+        cap.open(os.path.join(PROJECT_ROOT, "vid_h264.mp4"))
+        frame_count = sum(1 for _ in cap)
+        cap.release()
+        self.assertEqual(frame_count, 337)
+
+
+    def test_parallel_invalid_video(self):
+        cap = ParallelVideoCap(num_workers=2)
+        ret = cap.open(os.path.join(PROJECT_ROOT, "vid_not_existent.mp4"))
+        self.assertFalse(ret)
+        ret, frame, motion_vectors, frame_type, _ = cap.read()
+        self.assertFalse(ret)
+        self.assertIsNone(frame)
+
 
 if __name__ == '__main__':
     unittest.main()